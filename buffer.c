@@ -0,0 +1,104 @@
+#include "buffer.h"
+
+#include <stdarg.h>
+
+#define INITIAL_BUFFER_CAPACITY 256
+
+void init_buffer(Buffer* buf) {
+    memset(buf, 0, sizeof(Buffer));
+}
+
+void free_buffer(Buffer* buf) {
+    free(buf->data);
+    init_buffer(buf);
+}
+
+size_t buffer_used(Buffer* buf) {
+    return buf->len - buf->start;
+}
+
+/* buffer_reserve()
+ * −−−−−−−−−−−−−−−
+ * Makes room for at least size more bytes after buf->len, first by
+ * dropping consumed bytes and then by doubling the capacity.
+ *
+ * Returns: a pointer to the free space, to be filled before advancing
+ * buf->len.
+ */
+char* buffer_reserve(Buffer* buf, size_t size) {
+    if (buf->capacity - buf->len < size) {
+        buffer_compact(buf);
+    }
+    if (buf->capacity - buf->len < size) {
+        size_t capacity = buf->capacity ? buf->capacity
+                                        : INITIAL_BUFFER_CAPACITY;
+        while (capacity - buf->len < size) {
+            capacity *= 2;  // Double strategy
+        }
+        buf->data = x_realloc(buf->data, capacity);
+        buf->capacity = capacity;
+    }
+    return buf->data + buf->len;
+}
+
+void buffer_append(Buffer* buf, const char* data, size_t size) {
+    memcpy(buffer_reserve(buf, size), data, size);
+    buf->len += size;
+}
+
+void buffer_printf(Buffer* buf, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int size = vsnprintf(buf->data + buf->len, buf->capacity - buf->len,
+            format, args);
+    va_end(args);
+    if (size < 0) {
+        return;
+    }
+    if (size >= buf->capacity - buf->len) {
+        // Didn't fit, so make room and format again.
+        buffer_reserve(buf, size + 1);
+        va_start(args, format);
+        vsnprintf(buf->data + buf->len, size + 1, format, args);
+        va_end(args);
+    }
+    buf->len += size;
+}
+
+void buffer_consume(Buffer* buf, size_t size) {
+    buf->start += size;
+    if (buf->start >= buf->len) {
+        buf->start = buf->len = 0;
+    }
+}
+
+/* buffer_line()
+ * −−−−−−−−−−−−−−−
+ * Takes the next newline terminated line from the buffer, replacing the
+ * newline with a NUL terminator. The line stays valid until the buffer is
+ * next added to or compacted.
+ *
+ * Returns: the line, or NULL if the buffer holds no complete line.
+ */
+char* buffer_line(Buffer* buf) {
+    char* line = buf->data + buf->start;
+    char* newline = memchr(line, '\n', buffer_used(buf));
+    if (!newline) {
+        return NULL;
+    }
+    *newline = 0;
+    buf->start += newline - line + 1;
+    return line;
+}
+
+/* buffer_compact()
+ * −−−−−−−−−−−−−−−
+ * Moves the unconsumed bytes to the front of the buffer.
+ */
+void buffer_compact(Buffer* buf) {
+    if (buf->start) {
+        memmove(buf->data, buf->data + buf->start, buffer_used(buf));
+        buf->len -= buf->start;
+        buf->start = 0;
+    }
+}
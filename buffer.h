@@ -0,0 +1,26 @@
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include "util.h"
+
+// A growable byte buffer. Bytes are appended at len and consumed from
+// start, so the unconsumed data is data[start] to data[len - 1].
+typedef struct {
+    char* data;
+    size_t start;
+    size_t len;
+    size_t capacity;
+} Buffer;
+
+void init_buffer(Buffer* buf);
+void free_buffer(Buffer* buf);
+size_t buffer_used(Buffer* buf);
+char* buffer_reserve(Buffer* buf, size_t size);
+void buffer_append(Buffer* buf, const char* data, size_t size);
+void buffer_printf(Buffer* buf, const char* format, ...)
+        __attribute__((format(printf, 2, 3)));
+void buffer_consume(Buffer* buf, size_t size);
+char* buffer_line(Buffer* buf);
+void buffer_compact(Buffer* buf);
+
+#endif  // BUFFER_H
@@ -0,0 +1,231 @@
+#include "candidates.h"
+
+#include "hint.h"
+
+#define NUM_LETTERS     26
+#define SET_BITS        64
+#define STACK_HINTS     16  // More hints are collected on the heap
+#define MAX_HINT_MASKS  (2 * MAX_PATTERN_LEN)
+
+// The masks a candidate must be in, and must not be in, to fit one hint.
+typedef struct {
+    int numKeep;
+    int numDrop;
+    uint64_t* keep[MAX_HINT_MASKS];
+    uint64_t* drop[MAX_HINT_MASKS];
+} HintMasks;
+
+uint64_t* position_mask(CandidateMasks* masks, int pos, int letter);
+uint64_t* count_mask(CandidateMasks* masks, int wordLen, int letter,
+        int count);
+bool collect_masks(CandidateMasks* masks, int wordLen, char* guess,
+        uint32_t pattern, HintMasks* hint);
+uint64_t filter_word(HintMasks* hint, size_t word, uint64_t bits);
+
+/* init_candidate_index()
+ * −−−−−−−−−−−−−−−
+ * Builds the masks for every length of answer up to maxWordLen, which
+ * cost 2 * NUM_LETTERS * wordLen bits per answer.
+ */
+CandidateIndex* init_candidate_index(WordList* answers, int maxWordLen) {
+    CandidateIndex* index = x_calloc(1, sizeof(CandidateIndex));
+    index->maxWordLen = maxWordLen < MAX_PATTERN_LEN ? maxWordLen
+                                                     : MAX_PATTERN_LEN;
+    for (int len = 1; len <= index->maxWordLen; len++) {
+        CandidateMasks* masks = &index->lengths[len];
+        masks->words = count_words(answers, len);
+        masks->setWords = (masks->words + SET_BITS - 1) / SET_BITS;
+        if (!masks->words) {
+            continue;
+        }
+        masks->masks = x_calloc(2 * NUM_LETTERS * len * masks->setWords,
+                sizeof(uint64_t));
+        for (size_t i = 0; i < masks->words; i++) {
+            char* word = get_word(answers, len, i);
+            uint64_t bit = 1ull << i % SET_BITS;
+            int seen[NUM_LETTERS] = {0};
+            for (int pos = 0; pos < len; pos++) {
+                unsigned int letter = (unsigned char)word[pos] - 'a';
+                if (letter >= NUM_LETTERS) {
+                    continue;
+                }
+                position_mask(masks, pos, letter)[i / SET_BITS] |= bit;
+                seen[letter]++;
+                count_mask(masks, len, letter, seen[letter])[i / SET_BITS]
+                        |= bit;
+            }
+        }
+    }
+    return index;
+}
+
+void free_candidate_index(CandidateIndex* index) {
+    if (!index) {
+        return;
+    }
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        free(index->lengths[len].masks);
+    }
+    free(index);
+}
+
+uint64_t* position_mask(CandidateMasks* masks, int pos, int letter) {
+    return masks->masks + (pos * NUM_LETTERS + letter) * masks->setWords;
+}
+
+// The answers with at least count (1 to wordLen) of letter.
+uint64_t* count_mask(CandidateMasks* masks, int wordLen, int letter,
+        int count) {
+    return masks->masks + ((NUM_LETTERS + letter) * wordLen + count - 1)
+            * masks->setWords;
+}
+
+/* reset_candidates()
+ * −−−−−−−−−−−−−−−
+ * Fills set with every answer of length wordLen.
+ */
+void reset_candidates(CandidateIndex* index, int wordLen, uint64_t* set) {
+    CandidateMasks* masks = &index->lengths[wordLen];
+    memset(set, 0xff, masks->setWords * sizeof(uint64_t));
+    if (masks->words % SET_BITS) {
+        set[masks->setWords - 1] = (1ull << masks->words % SET_BITS) - 1;
+    }
+}
+
+/* collect_masks()
+ * −−−−−−−−−−−−−−−
+ * Works out the masks an answer must be in (keep) and must not be in
+ * (drop) to have given the hint pattern (see get_hint()) for guess. A
+ * correct letter keeps the answers with it in that position and any other
+ * letter drops them, then each letter keeps the answers with at least as
+ * many of it as were matched and, if it was also wrong somewhere, drops
+ * those with more. Masks implied by others are left out.
+ *
+ * Returns: false if the guess is not all lower case letters, otherwise
+ * true.
+ */
+bool collect_masks(CandidateMasks* masks, int wordLen, char* guess,
+        uint32_t pattern, HintMasks* hint) {
+    int matched[NUM_LETTERS] = {0};
+    bool correct[NUM_LETTERS] = {false};
+    bool capped[NUM_LETTERS] = {false};
+    bool seen[NUM_LETTERS] = {false};
+    unsigned int letters[MAX_PATTERN_LEN];
+    uint32_t digits = pattern;
+    for (int pos = 0; pos < wordLen; pos++, digits /= 3) {
+        letters[pos] = (unsigned char)guess[pos] - 'a';
+        if (letters[pos] >= NUM_LETTERS) {
+            return false;
+        }
+        if (digits % 3 == HINT_WRONG) {
+            capped[letters[pos]] = true;
+        } else {
+            correct[letters[pos]] |= digits % 3 == HINT_CORRECT;
+            matched[letters[pos]]++;
+        }
+    }
+
+    hint->numKeep = hint->numDrop = 0;
+    digits = pattern;
+    for (int pos = 0; pos < wordLen; pos++, digits /= 3) {
+        unsigned int letter = letters[pos];
+        uint64_t* mask = position_mask(masks, pos, letter);
+        if (digits % 3 == HINT_CORRECT) {
+            hint->keep[hint->numKeep++] = mask;
+        } else if (matched[letter]) {
+            // Letters not in the answer at all are dropped by count below.
+            hint->drop[hint->numDrop++] = mask;
+        }
+        // Each letter of the guess adds its count masks once, rather than
+        // checking every letter of the alphabet.
+        if (seen[letter]) {
+            continue;
+        }
+        seen[letter] = true;
+        if (matched[letter] > 1
+                || (matched[letter] == 1 && !correct[letter])) {
+            hint->keep[hint->numKeep++] = count_mask(masks, wordLen, letter,
+                    matched[letter]);
+        }
+        if (capped[letter] && matched[letter] < wordLen) {
+            hint->drop[hint->numDrop++] = count_mask(masks, wordLen, letter,
+                    matched[letter] + 1);
+        }
+    }
+    return true;
+}
+
+// Filters one word of a candidate set by the masks of a hint.
+uint64_t filter_word(HintMasks* hint, size_t word, uint64_t bits) {
+    for (int i = 0; bits && i < hint->numKeep; i++) {
+        bits &= hint->keep[i][word];
+    }
+    for (int i = 0; bits && i < hint->numDrop; i++) {
+        bits &= ~hint->drop[i][word];
+    }
+    return bits;
+}
+
+/* apply_hint()
+ * −−−−−−−−−−−−−−−
+ * Removes the answers from set that would not have given the hint pattern
+ * for guess.
+ */
+void apply_hint(CandidateIndex* index, int wordLen, char* guess,
+        uint32_t pattern, uint64_t* set) {
+    CandidateMasks* masks = &index->lengths[wordLen];
+    HintMasks hint;
+    if (!collect_masks(masks, wordLen, guess, pattern, &hint)) {
+        memset(set, 0, masks->setWords * sizeof(uint64_t));
+        return;
+    }
+    for (size_t i = 0; i < masks->setWords; i++) {
+        set[i] = filter_word(&hint, i, set[i]);
+    }
+}
+
+size_t count_candidates(CandidateIndex* index, int wordLen, uint64_t* set) {
+    size_t count = 0;
+    for (size_t i = 0; i < index->lengths[wordLen].setWords; i++) {
+        count += __builtin_popcountll(set[i]);
+    }
+    return count;
+}
+
+/* candidates_left()
+ * −−−−−−−−−−−−−−−
+ * Counts the answers of length wordLen consistent with every one of the
+ * numHints guesses and their hint patterns. Rather than filtering a whole
+ * set by each hint in turn, each word of the set is filtered by every hint
+ * and counted while in a register, and skips the rest once it is empty.
+ */
+size_t candidates_left(CandidateIndex* index, int wordLen, char** guesses,
+        uint32_t* patterns, int numHints) {
+    if (wordLen < 1 || wordLen > index->maxWordLen) {
+        return 0;
+    }
+    CandidateMasks* masks = &index->lengths[wordLen];
+    HintMasks stackHints[STACK_HINTS];
+    HintMasks* hints = numHints <= STACK_HINTS
+            ? stackHints : x_malloc(sizeof(HintMasks) * numHints);
+    bool valid = true;
+    for (int i = 0; valid && i < numHints; i++) {
+        valid = collect_masks(masks, wordLen, guesses[i], patterns[i],
+                &hints[i]);
+    }
+    size_t count = 0;
+    for (size_t i = 0; valid && i < masks->setWords; i++) {
+        uint64_t bits = UINT64_MAX;
+        if (i == masks->setWords - 1 && masks->words % SET_BITS) {
+            bits = (1ull << masks->words % SET_BITS) - 1;
+        }
+        for (int j = 0; bits && j < numHints; j++) {
+            bits = filter_word(&hints[j], i, bits);
+        }
+        count += __builtin_popcountll(bits);
+    }
+    if (hints != stackHints) {
+        free(hints);
+    }
+    return count;
+}
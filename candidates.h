@@ -0,0 +1,34 @@
+#ifndef CANDIDATES_H
+#define CANDIDATES_H
+
+#include <stdint.h>
+
+#include "util.h"
+#include "wordList.h"
+
+// Bitsets over the answers of one length, bit i standing for the answer at
+// position i (see get_word()). Every mask is setWords uint64_t words.
+typedef struct {
+    size_t words;     // Answers of this length
+    size_t setWords;
+    uint64_t* masks;  // The position masks, then the letter count masks
+} CandidateMasks;
+
+// Precomputed masks for filtering answers by the hints they are consistent
+// with: for each position and letter, the answers with that letter there,
+// and for each letter and count n, the answers with at least n of it.
+typedef struct {
+    int maxWordLen;
+    CandidateMasks lengths[MAX_LIST_WORD_LEN + 1];
+} CandidateIndex;
+
+CandidateIndex* init_candidate_index(WordList* answers, int maxWordLen);
+void free_candidate_index(CandidateIndex* index);
+void reset_candidates(CandidateIndex* index, int wordLen, uint64_t* set);
+void apply_hint(CandidateIndex* index, int wordLen, char* guess,
+        uint32_t pattern, uint64_t* set);
+size_t count_candidates(CandidateIndex* index, int wordLen, uint64_t* set);
+size_t candidates_left(CandidateIndex* index, int wordLen, char** guesses,
+        uint32_t* patterns, int numHints);
+
+#endif  // CANDIDATES_H
@@ -0,0 +1,73 @@
+#include "daily.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#include "util.h"
+
+#define SECONDS_PER_DAY 86400
+#define PUZZLE_BITS     24
+#define PUZZLE_MASK     ((1ull << PUZZLE_BITS) - 1)
+
+long days_since_epoch(int year, int month, int day);
+
+/* init_daily_clock()
+ * −−−−−−−−−−−−−−−
+ * Returns: a clock numbering days from launchDate, given as YYYY-MM-DD, or
+ * NULL if that is not a valid date.
+ */
+DailyClock* init_daily_clock(char* launchDate) {
+    int year, month, day, len = 0;
+    if (sscanf(launchDate, "%4d-%2d-%2d%n", &year, &month, &day, &len) != 3
+            || launchDate[len]) {
+        return NULL;
+    }
+    // Out of range days and months would be normalised, so compare back.
+    struct tm date = {.tm_year = year - 1900, .tm_mon = month - 1,
+            .tm_mday = day};
+    time_t raw = timegm(&date);
+    if (date.tm_year != year - 1900 || date.tm_mon != month - 1
+            || date.tm_mday != day) {
+        return NULL;
+    }
+    DailyClock* clock = x_calloc(1, sizeof(DailyClock));
+    clock->launch = raw / SECONDS_PER_DAY;
+    return clock;
+}
+
+long days_since_epoch(int year, int month, int day) {
+    struct tm date = {.tm_year = year, .tm_mon = month, .tm_mday = day};
+    return timegm(&date) / SECONDS_PER_DAY;
+}
+
+/* current_puzzle()
+ * −−−−−−−−−−−−−−−
+ * Returns today's puzzle number, or 0 before the launch date. The number is
+ * kept packed with the time it ends in one atomic word, so until local
+ * midnight a caller reads the clock and that word and takes no lock. The
+ * first caller after midnight works out the new day (any others racing it
+ * get the same answer) and stores it for everyone else.
+ */
+int current_puzzle(DailyClock* clock) {
+    uint64_t today = __atomic_load_n(&clock->today, __ATOMIC_RELAXED);
+    time_t now = time(NULL);
+    if (today && now < (time_t)(today >> PUZZLE_BITS)) {
+        return today & PUZZLE_MASK;
+    }
+    struct tm local;
+    localtime_r(&now, &local);
+    long puzzle = days_since_epoch(local.tm_year, local.tm_mon, local.tm_mday)
+            - clock->launch;
+    if (puzzle < 0) {
+        puzzle = 0;
+    } else if (puzzle > PUZZLE_MASK) {
+        puzzle = PUZZLE_MASK;
+    }
+    local.tm_mday++;
+    local.tm_hour = local.tm_min = local.tm_sec = 0;
+    local.tm_isdst = -1;
+    time_t ends = mktime(&local);
+    __atomic_store_n(&clock->today, (uint64_t)ends << PUZZLE_BITS | puzzle,
+            __ATOMIC_RELAXED);
+    return puzzle;
+}
@@ -0,0 +1,17 @@
+#ifndef DAILY_H
+#define DAILY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Numbers the days since a launch date, rolling over at local midnight.
+typedef struct {
+    long launch;     // The date of puzzle 0, in days since the epoch
+    uint64_t today;  // When today's puzzle ends and its number (see
+                     // current_puzzle()), or 0 before the first call
+} DailyClock;
+
+DailyClock* init_daily_clock(char* launchDate);
+int current_puzzle(DailyClock* clock);
+
+#endif  // DAILY_H
@@ -0,0 +1,193 @@
+#include "dictionary.h"
+
+#include <sched.h>
+
+Dictionary* load_dictionary(DictionaryStore* store, bool needMatrix);
+void free_dictionary(Dictionary* dictionary);
+uint32_t* schedule_answers(WordList* answers, int wordLen, uint64_t seed);
+
+/* init_dictionary_store()
+ * −−−−−−−−−−−−−−−
+ * Loads the first generation of the word lists from the given paths,
+ * which are read again on each reload. If daily is true, each generation
+ * also shuffles its answers of minWordLen to maxWordLen letters into a
+ * schedule of daily answers by dailySeed.
+ *
+ * Returns: the store, or NULL if the lists could not be loaded.
+ */
+DictionaryStore* init_dictionary_store(char* answersPath, char* guessesPath,
+        char* matrixPath, int minWordLen, int maxWordLen, bool daily,
+        uint64_t dailySeed) {
+    DictionaryStore* store = x_calloc(1, sizeof(DictionaryStore));
+    store->answersPath = answersPath;
+    store->guessesPath = guessesPath;
+    store->matrixPath = matrixPath;
+    store->minWordLen = minWordLen;
+    store->maxWordLen = maxWordLen;
+    store->daily = daily;
+    store->dailySeed = dailySeed;
+    if (!(store->current = load_dictionary(store, true))) {
+        free(store);
+        return NULL;
+    }
+    return store;
+}
+
+void free_dictionary_store(DictionaryStore* store) {
+    if (!store) {
+        return;
+    }
+    release_dictionary(store->current);
+    free(store);
+}
+
+/* load_dictionary()
+ * −−−−−−−−−−−−−−−
+ * Reads the word lists and feedback matrix from the store's paths. A
+ * matrix that no longer matches the lists is fatal at startup; on reload
+ * the lists are used without it.
+ *
+ * Returns: the new generation with the store's reference, or NULL.
+ */
+Dictionary* load_dictionary(DictionaryStore* store, bool needMatrix) {
+    Dictionary* dictionary = x_calloc(1, sizeof(Dictionary));
+    dictionary->answers = init_word_list(store->answersPath);
+    dictionary->guesses = init_word_list(store->guessesPath);
+    if (!dictionary->answers || !dictionary->guesses) {
+        free_dictionary(dictionary);
+        return NULL;
+    }
+    if (store->matrixPath && !(dictionary->matrix = load_feedback_matrix(
+                                       store->matrixPath, dictionary->answers,
+                                       dictionary->guesses))) {
+        if (needMatrix) {
+            free_dictionary(dictionary);
+            return NULL;
+        }
+        fprintf(stderr, "%s: not used until it is rebuilt\n",
+                store->matrixPath);
+    }
+    dictionary->candidates = init_candidate_index(dictionary->answers,
+            store->maxWordLen);
+    for (int len = store->minWordLen; store->daily && len <= store->maxWordLen;
+            len++) {
+        dictionary->schedules[len] = schedule_answers(dictionary->answers,
+                len, store->dailySeed);
+    }
+    dictionary->refs = 1;
+    dictionary->generation = ++store->generations;
+    return dictionary;
+}
+
+void free_dictionary(Dictionary* dictionary) {
+    free_word_list(dictionary->answers);
+    free_word_list(dictionary->guesses);
+    free_feedback_matrix(dictionary->matrix);
+    free_candidate_index(dictionary->candidates);
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        free(dictionary->schedules[len]);
+    }
+    free(dictionary);
+}
+
+/* schedule_answers()
+ * −−−−−−−−−−−−−−−
+ * Shuffles the positions of the answers of length wordLen, the same way for
+ * the same list and seed, so a restart keeps the schedule.
+ *
+ * Returns: the shuffled positions, or NULL if there are no such answers.
+ */
+uint32_t* schedule_answers(WordList* answers, int wordLen, uint64_t seed) {
+    size_t count = count_words(answers, wordLen);
+    if (!count) {
+        return NULL;
+    }
+    uint32_t* schedule = x_malloc(sizeof(uint32_t) * count);
+    for (size_t i = 0; i < count; i++) {
+        schedule[i] = i;
+    }
+    Rng rng;
+    seed_rng(&rng, seed, wordLen);
+    for (size_t i = count - 1; i > 0; i--) {
+        size_t j = random_below(&rng, i + 1);
+        uint32_t swap = schedule[i];
+        schedule[i] = schedule[j];
+        schedule[j] = swap;
+    }
+    return schedule;
+}
+
+/* acquire_dictionary()
+ * −−−−−−−−−−−−−−−
+ * Takes a reference to the current generation without locking. While a
+ * reader is between loading the pointer and counting its reference, it is
+ * counted in acquiring, and a reload waits for that to drain before it
+ * drops the store's reference to the generation it replaced.
+ *
+ * Returns: the current generation, to be released by the caller.
+ */
+Dictionary* acquire_dictionary(DictionaryStore* store) {
+    __atomic_add_fetch(&store->acquiring, 1, __ATOMIC_SEQ_CST);
+    Dictionary* dictionary = __atomic_load_n(&store->current,
+            __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&dictionary->refs, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&store->acquiring, 1, __ATOMIC_RELEASE);
+    return dictionary;
+}
+
+// Drops a reference, freeing the generation if it was the last.
+void release_dictionary(Dictionary* dictionary) {
+    if (dictionary
+            && !__atomic_sub_fetch(&dictionary->refs, 1, __ATOMIC_ACQ_REL)) {
+        free_dictionary(dictionary);
+    }
+}
+
+/* reload_dictionary()
+ * −−−−−−−−−−−−−−−
+ * Loads a new generation of the word lists and publishes it with an atomic
+ * swap. Readers are never blocked: those holding the old generation keep
+ * it until they release it, and the last of them frees it. Only one reload
+ * may run at a time.
+ *
+ * Returns: false, keeping the current generation, if the lists could not
+ * be loaded, otherwise true.
+ */
+bool reload_dictionary(DictionaryStore* store) {
+    Dictionary* fresh = load_dictionary(store, false);
+    if (!fresh) {
+        return false;
+    }
+    Dictionary* old = __atomic_exchange_n(&store->current, fresh,
+            __ATOMIC_SEQ_CST);
+    // Readers that loaded the old pointer are done counting it once this
+    // is seen to drain; any that start later load the fresh one.
+    while (__atomic_load_n(&store->acquiring, __ATOMIC_SEQ_CST)) {
+        sched_yield();
+    }
+    release_dictionary(old);
+    return true;
+}
+
+/* get_daily_word()
+ * −−−−−−−−−−−−−−−
+ * Looks up the answer of length wordLen for a daily puzzle, going round
+ * the schedule again once every answer has been used, and, if pos is not
+ * NULL, sets pos to its position (see get_word()).
+ *
+ * Returns: the answer, or NULL if there are no daily answers of that
+ * length.
+ */
+char* get_daily_word(Dictionary* dictionary, int wordLen, int puzzle,
+        size_t* pos) {
+    if (wordLen < 0 || wordLen > MAX_LIST_WORD_LEN
+            || !dictionary->schedules[wordLen]) {
+        return NULL;
+    }
+    size_t i = dictionary->schedules[wordLen][puzzle
+            % count_words(dictionary->answers, wordLen)];
+    if (pos) {
+        *pos = i;
+    }
+    return get_word(dictionary->answers, wordLen, i);
+}
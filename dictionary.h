@@ -0,0 +1,47 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include "candidates.h"
+#include "feedbackMatrix.h"
+#include "util.h"
+#include "wordList.h"
+
+// One generation of the word lists and everything derived from them. Each
+// user holds a reference, so a reload never frees lists from under a game.
+typedef struct {
+    WordList* answers;
+    WordList* guesses;
+    FeedbackMatrix* matrix;  // Precomputed hints, or NULL
+    CandidateIndex* candidates;
+    // The daily answers of each length, as positions in answers, or NULL
+    uint32_t* schedules[MAX_LIST_WORD_LEN + 1];
+    int refs;
+    int generation;
+} Dictionary;
+
+// Publishes the current Dictionary. Readers take references without
+// locking (see acquire_dictionary()) and a reload swaps in a new one.
+typedef struct {
+    Dictionary* current;
+    int acquiring;  // Readers that may have loaded current but not counted it
+    char* answersPath;
+    char* guessesPath;
+    char* matrixPath;  // Or NULL
+    int minWordLen;    // Shortest answers scheduled for daily play
+    int maxWordLen;    // Longest answers indexed and scheduled
+    bool daily;        // Whether to schedule daily answers
+    uint64_t dailySeed;
+    int generations;
+} DictionaryStore;
+
+DictionaryStore* init_dictionary_store(char* answersPath, char* guessesPath,
+        char* matrixPath, int minWordLen, int maxWordLen, bool daily,
+        uint64_t dailySeed);
+void free_dictionary_store(DictionaryStore* store);
+Dictionary* acquire_dictionary(DictionaryStore* store);
+void release_dictionary(Dictionary* dictionary);
+bool reload_dictionary(DictionaryStore* store);
+char* get_daily_word(Dictionary* dictionary, int wordLen, int puzzle,
+        size_t* pos);
+
+#endif  // DICTIONARY_H
@@ -0,0 +1,325 @@
+#include "feedbackMatrix.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hint.h"
+
+#define MATRIX_MAGIC      "WRDLMTRX"
+#define MATRIX_MAGIC_LEN  8
+#define MATRIX_VERSION    1
+#define MATRIX_BYTE_ORDER 0x01020304u
+#define MATRIX_ALIGN      64
+
+#define SMALL_CELL_LEN 5    // Longest word whose patterns fit in 1 byte
+#define ROWS_PER_TASK  16
+
+#define FNV64_OFFSET_BASIS 14695981039346656037ull
+#define FNV64_PRIME        1099511628211ull
+
+/* Header of a feedback matrix file. Each length with a block stores a
+ * guesses x answers array of pattern ids (see get_hint()) in row major
+ * order at the given file offset. The checksum covers the guesses and
+ * answers of that length so a matrix is never used with other word lists.
+ */
+typedef struct {
+    char magic[MATRIX_MAGIC_LEN];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t maxWordLen;
+    uint32_t reserved;
+    struct {
+        uint64_t guesses;
+        uint64_t answers;
+        uint64_t cellSize;
+        uint64_t offset;
+        uint64_t checksum;
+    } blocks[MAX_LIST_WORD_LEN + 1];
+} MatrixHeader;
+
+// State shared by the threads filling in a matrix. Work is handed out in
+// tasks of ROWS_PER_TASK rows of one length.
+typedef struct {
+    FeedbackMatrix* matrix;
+    WordList* answers;
+    WordList* guesses;
+    size_t tasks[MAX_LIST_WORD_LEN + 2];  // First task of each length
+    size_t nextTask;
+} MatrixJob;
+
+uint64_t checksum_words(uint64_t hash, WordList* list, int wordLen);
+size_t plan_matrix(MatrixHeader* header, WordList* answers,
+        WordList* guesses);
+void* fill_thread(void* rawJob);
+void fill_rows(MatrixJob* job, int wordLen, size_t firstRow, size_t lastRow);
+
+/* checksum_words()
+ * −−−−−−−−−−−−−−−
+ * Continues a 64-bit FNV-1a hash over the words of length wordLen.
+ */
+uint64_t checksum_words(uint64_t hash, WordList* list, int wordLen) {
+    size_t size = count_words(list, wordLen) * (wordLen + 1);
+    char* words = list->buckets[wordLen].words;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (unsigned char)words[i];
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+/* plan_matrix()
+ * −−−−−−−−−−−−−−−
+ * Fills in the header for a matrix over every length up to
+ * MAX_MATRIX_WORD_LEN that has both guesses and answers.
+ *
+ * Returns: the size of the matrix file in bytes.
+ */
+size_t plan_matrix(MatrixHeader* header, WordList* answers,
+        WordList* guesses) {
+    memset(header, 0, sizeof(MatrixHeader));
+    memcpy(header->magic, MATRIX_MAGIC, MATRIX_MAGIC_LEN);
+    header->version = MATRIX_VERSION;
+    header->byteOrder = MATRIX_BYTE_ORDER;
+    header->maxWordLen = MAX_LIST_WORD_LEN;
+
+    size_t offset = (sizeof(MatrixHeader) + MATRIX_ALIGN - 1)
+            / MATRIX_ALIGN * MATRIX_ALIGN;
+    for (int len = 1; len <= MAX_MATRIX_WORD_LEN; len++) {
+        size_t rows = count_words(guesses, len);
+        size_t columns = count_words(answers, len);
+        if (!rows || !columns) {
+            continue;
+        }
+        header->blocks[len].guesses = rows;
+        header->blocks[len].answers = columns;
+        header->blocks[len].cellSize = len <= SMALL_CELL_LEN ? 1 : 2;
+        header->blocks[len].offset = offset;
+        header->blocks[len].checksum = checksum_words(
+                checksum_words(FNV64_OFFSET_BASIS, guesses, len), answers,
+                len);
+        offset += rows * columns * header->blocks[len].cellSize;
+        offset = (offset + MATRIX_ALIGN - 1) / MATRIX_ALIGN * MATRIX_ALIGN;
+    }
+    return offset;
+}
+
+/* save_feedback_matrix()
+ * −−−−−−−−−−−−−−−
+ * Computes the pattern id of every guess against every answer of the same
+ * length and writes them to path as a feedback matrix. The file is mapped
+ * and filled in place by numThreads threads, then renamed into place.
+ *
+ * Returns: true if the matrix was written, otherwise false.
+ */
+bool save_feedback_matrix(char* path, WordList* answers, WordList* guesses,
+        int numThreads) {
+    MatrixHeader header;
+    size_t size = plan_matrix(&header, answers, guesses);
+
+    char* tempPath = x_malloc(strlen(path) + sizeof(".tmp"));
+    sprintf(tempPath, "%s.tmp", path);
+    int fd = open(tempPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("open");
+        free(tempPath);
+        return false;
+    }
+    char* data = MAP_FAILED;
+    if (!ftruncate(fd, size)) {
+        data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("save_feedback_matrix");
+        unlink(tempPath);
+        free(tempPath);
+        return false;
+    }
+    memcpy(data, &header, sizeof(MatrixHeader));
+
+    FeedbackMatrix matrix;
+    MatrixJob job;
+    memset(&matrix, 0, sizeof(FeedbackMatrix));
+    memset(&job, 0, sizeof(MatrixJob));
+    job.matrix = &matrix;
+    job.answers = answers;
+    job.guesses = guesses;
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        MatrixBlock* block = &matrix.blocks[len];
+        block->guesses = header.blocks[len].guesses;
+        block->answers = header.blocks[len].answers;
+        block->cellSize = header.blocks[len].cellSize;
+        block->cells = (unsigned char*)data + header.blocks[len].offset;
+        job.tasks[len + 1] = job.tasks[len]
+                + (block->guesses + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    }
+
+    pthread_t* tids = x_malloc(sizeof(pthread_t) * numThreads);
+    int started = 0;
+    while (started < numThreads - 1
+            && !pthread_create(&tids[started], NULL, fill_thread, &job)) {
+        started++;
+    }
+    fill_thread(&job);  // Also work on this thread
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    free(tids);
+
+    bool ok = !msync(data, size, MS_SYNC);
+    munmap(data, size);
+    if (!ok || rename(tempPath, path)) {
+        perror("save_feedback_matrix");
+        unlink(tempPath);
+        ok = false;
+    }
+    free(tempPath);
+    return ok;
+}
+
+void* fill_thread(void* rawJob) {
+    MatrixJob* job = rawJob;
+    size_t numTasks = job->tasks[MAX_LIST_WORD_LEN + 1];
+    int len = 0;
+    size_t task;
+    while ((task = __atomic_fetch_add(&job->nextTask, 1, __ATOMIC_RELAXED))
+            < numTasks) {
+        // Tasks are handed out in order, so the length only moves forward.
+        while (task >= job->tasks[len + 1]) {
+            len++;
+        }
+        size_t firstRow = (task - job->tasks[len]) * ROWS_PER_TASK;
+        size_t lastRow = firstRow + ROWS_PER_TASK;
+        if (lastRow > job->matrix->blocks[len].guesses) {
+            lastRow = job->matrix->blocks[len].guesses;
+        }
+        fill_rows(job, len, firstRow, lastRow);
+    }
+    return NULL;
+}
+
+void fill_rows(MatrixJob* job, int wordLen, size_t firstRow, size_t lastRow) {
+    MatrixBlock* block = &job->matrix->blocks[wordLen];
+    char hint[MAX_MATRIX_WORD_LEN + 1];
+    for (size_t row = firstRow; row < lastRow; row++) {
+        char* guess = get_word(job->guesses, wordLen, row);
+        unsigned char* cell = block->cells
+                + row * block->answers * block->cellSize;
+        for (size_t column = 0; column < block->answers; column++) {
+            uint32_t pattern = get_hint(guess,
+                    get_word(job->answers, wordLen, column), wordLen, hint);
+            if (block->cellSize == 1) {
+                *cell++ = pattern;
+            } else {
+                uint16_t wide = pattern;
+                memcpy(cell, &wide, sizeof(uint16_t));
+                cell += sizeof(uint16_t);
+            }
+        }
+    }
+}
+
+/* load_feedback_matrix()
+ * −−−−−−−−−−−−−−−
+ * Maps the feedback matrix at path read-only and checks that every length
+ * it covers was computed from the given answers and guesses.
+ *
+ * Returns: the matrix, or NULL if it could not be read, is invalid or was
+ * built from other word lists.
+ */
+FeedbackMatrix* load_feedback_matrix(char* path, WordList* answers,
+        WordList* guesses) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return NULL;
+    }
+    struct stat st;
+    char* data = MAP_FAILED;
+    if (!fstat(fd, &st) && st.st_size >= sizeof(MatrixHeader)) {
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "%s: invalid feedback matrix\n", path);
+        return NULL;
+    }
+
+    MatrixHeader* header = (MatrixHeader*)data;
+    bool ok = !memcmp(header->magic, MATRIX_MAGIC, MATRIX_MAGIC_LEN)
+            && header->version == MATRIX_VERSION
+            && header->byteOrder == MATRIX_BYTE_ORDER
+            && header->maxWordLen == MAX_LIST_WORD_LEN;
+    FeedbackMatrix* matrix = x_calloc(1, sizeof(FeedbackMatrix));
+    for (int len = 0; ok && len <= MAX_LIST_WORD_LEN; len++) {
+        MatrixBlock* block = &matrix->blocks[len];
+        block->guesses = header->blocks[len].guesses;
+        block->answers = header->blocks[len].answers;
+        block->cellSize = header->blocks[len].cellSize;
+        if (!block->cellSize) {
+            continue;
+        }
+        size_t cells = block->guesses * block->answers;
+        ok = block->guesses == count_words(guesses, len)
+                && block->answers == count_words(answers, len)
+                && block->cellSize <= sizeof(uint16_t)
+                && header->blocks[len].offset <= st.st_size
+                && cells <= (st.st_size - header->blocks[len].offset)
+                        / block->cellSize
+                && header->blocks[len].checksum == checksum_words(
+                        checksum_words(FNV64_OFFSET_BASIS, guesses, len),
+                        answers, len);
+        block->cells = (unsigned char*)data + header->blocks[len].offset;
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: feedback matrix does not match the word lists\n",
+                path);
+        munmap(data, st.st_size);
+        free(matrix);
+        return NULL;
+    }
+    matrix->mapping = data;
+    matrix->mappingSize = st.st_size;
+    return matrix;
+}
+
+void free_feedback_matrix(FeedbackMatrix* matrix) {
+    if (!matrix) {
+        return;
+    }
+    munmap(matrix->mapping, matrix->mappingSize);
+    free(matrix);
+}
+
+/* lookup_pattern()
+ * −−−−−−−−−−−−−−−
+ * Finds the pattern id of the guess and answer at the given positions of
+ * their word lists (see find_word()).
+ *
+ * Returns: true if the matrix covers wordLen and pattern was set,
+ * otherwise false.
+ */
+bool lookup_pattern(FeedbackMatrix* matrix, int wordLen, size_t guessPos,
+        size_t answerPos, uint32_t* pattern) {
+    if (wordLen < 0 || wordLen > MAX_LIST_WORD_LEN) {
+        return false;
+    }
+    MatrixBlock* block = &matrix->blocks[wordLen];
+    if (!block->cellSize || guessPos >= block->guesses
+            || answerPos >= block->answers) {
+        return false;
+    }
+    unsigned char* cell = block->cells
+            + (guessPos * block->answers + answerPos) * block->cellSize;
+    if (block->cellSize == 1) {
+        *pattern = *cell;
+    } else {
+        uint16_t wide;
+        memcpy(&wide, cell, sizeof(uint16_t));
+        *pattern = wide;
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef FEEDBACK_MATRIX_H
+#define FEEDBACK_MATRIX_H
+
+#include "wordList.h"
+
+#define MAX_MATRIX_WORD_LEN 10  // Longest word whose patterns fit in 2 bytes
+
+typedef struct {
+    size_t guesses;       // Rows, one per guess of this length
+    size_t answers;       // Columns, one per answer of this length
+    size_t cellSize;      // Bytes per pattern id, 0 if the length is absent
+    unsigned char* cells;
+} MatrixBlock;
+
+typedef struct {
+    MatrixBlock blocks[MAX_LIST_WORD_LEN + 1];
+    char* mapping;
+    size_t mappingSize;
+} FeedbackMatrix;
+
+bool save_feedback_matrix(char* path, WordList* answers, WordList* guesses,
+        int numThreads);
+FeedbackMatrix* load_feedback_matrix(char* path, WordList* answers,
+        WordList* guesses);
+void free_feedback_matrix(FeedbackMatrix* matrix);
+bool lookup_pattern(FeedbackMatrix* matrix, int wordLen, size_t guessPos,
+        size_t answerPos, uint32_t* pattern);
+
+#endif  // FEEDBACK_MATRIX_H
@@ -0,0 +1,70 @@
+#include "hint.h"
+
+#define NUM_LETTERS 26
+
+/* get_hint()
+ * −−−−−−−−−−−−−−−
+ * Compares the lower case guess with the answer, both wordLen letters long,
+ * and writes the hint into the caller's buffer of at least wordLen + 1
+ * bytes. Correct letters are shown in upper case, letters in the wrong
+ * position in lower case and all others as WRONG_GUESS. A repeated letter
+ * is only shown as misplaced as many times as it is left unmatched in the
+ * answer, counting from the left.
+ *
+ * Rather than rescanning the answer for each letter, the letters of the
+ * answer that are not exact matches are tallied once and each misplaced
+ * letter takes one from its tally.
+ *
+ * Returns: the hint as a base-3 pattern id (see HINT_CORRECT), which is
+ * only meaningful when wordLen <= MAX_PATTERN_LEN.
+ */
+uint32_t get_hint(char* guess, char* answer, int wordLen, char* hint) {
+    int unmatched[NUM_LETTERS] = {0};
+    for (int i = 0; i < wordLen; i++) {
+        unsigned int letter = (unsigned char)answer[i] - 'a';
+        bool correct = answer[i] == guess[i];
+        hint[i] = correct ? toupper(guess[i]) : 0;
+        if (!correct && letter < NUM_LETTERS) {
+            unmatched[letter]++;
+        }
+    }
+
+    uint32_t pattern = 0, place = 1;
+    for (int i = 0; i < wordLen; i++, place *= 3) {
+        if (hint[i]) {
+            pattern += HINT_CORRECT * place;
+            continue;
+        }
+        unsigned int letter = (unsigned char)guess[i] - 'a';
+        if (letter < NUM_LETTERS && unmatched[letter]) {
+            unmatched[letter]--;
+            hint[i] = guess[i];
+            pattern += HINT_MISPLACED * place;
+        } else {
+            hint[i] = WRONG_GUESS;
+        }
+    }
+    hint[wordLen] = 0;
+    return pattern;
+}
+
+/* render_hint()
+ * −−−−−−−−−−−−−−−
+ * Writes the hint string for a pattern id returned by get_hint() for guess
+ * into the caller's buffer of at least wordLen + 1 bytes.
+ */
+void render_hint(uint32_t pattern, char* guess, int wordLen, char* hint) {
+    for (int i = 0; i < wordLen; i++, pattern /= 3) {
+        switch (pattern % 3) {
+            case HINT_CORRECT:
+                hint[i] = toupper(guess[i]);
+                break;
+            case HINT_MISPLACED:
+                hint[i] = guess[i];
+                break;
+            default:
+                hint[i] = WRONG_GUESS;
+        }
+    }
+    hint[wordLen] = 0;
+}
@@ -0,0 +1,21 @@
+#ifndef HINT_H
+#define HINT_H
+
+#include <stdint.h>
+
+#include "util.h"
+
+#define WRONG_GUESS '-'
+
+// Base-3 digits of a hint pattern, one per letter with the first letter
+// least significant.
+#define HINT_WRONG     0
+#define HINT_MISPLACED 1
+#define HINT_CORRECT   2
+
+#define MAX_PATTERN_LEN 20  // Longest word whose pattern fits in uint32_t
+
+uint32_t get_hint(char* guess, char* answer, int wordLen, char* hint);
+void render_hint(uint32_t pattern, char* guess, int wordLen, char* hint);
+
+#endif  // HINT_H
@@ -0,0 +1,85 @@
+#include "histogram.h"
+
+#define SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+
+int value_bucket(uint64_t value);
+void add_count(uint64_t* count, uint64_t value);
+
+int value_bucket(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+    int bit = 63 - __builtin_clzll(value);
+    if (bit > HISTOGRAM_MAX_BIT) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+    int shift = bit - HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << HISTOGRAM_SUB_BITS)
+            + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+// Returns: the largest value that falls in the bucket.
+uint64_t bucket_limit(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = (bucket >> HISTOGRAM_SUB_BITS) - 1;
+    uint64_t low = (uint64_t)(SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1)))
+            << shift;
+    return low + (1ull << shift) - 1;
+}
+
+// Adds to a count only its owner writes, so it needs no locked
+// instruction, but may be read by other threads at any time.
+void add_count(uint64_t* count, uint64_t value) {
+    __atomic_store_n(count, __atomic_load_n(count, __ATOMIC_RELAXED) + value,
+            __ATOMIC_RELAXED);
+}
+
+/* record_value()
+ * −−−−−−−−−−−−−−−
+ * Adds a value to a histogram that only the calling thread records to.
+ * Other threads may read it meanwhile with add_histogram().
+ */
+void record_value(Histogram* histogram, uint64_t value) {
+    add_count(&histogram->counts[value_bucket(value)], 1);
+    add_count(&histogram->count, 1);
+    add_count(&histogram->sum, value);
+}
+
+// Adds the counts of a histogram that may be being recorded to into total.
+void add_histogram(Histogram* total, Histogram* histogram) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        total->counts[i] += __atomic_load_n(&histogram->counts[i],
+                __ATOMIC_RELAXED);
+    }
+    total->count += __atomic_load_n(&histogram->count, __ATOMIC_RELAXED);
+    total->sum += __atomic_load_n(&histogram->sum, __ATOMIC_RELAXED);
+}
+
+/* histogram_quantile()
+ * −−−−−−−−−−−−−−−
+ * Returns: the upper limit of the bucket holding the given quantile (0 to
+ * 1) of the recorded values, or 0 if there are none.
+ */
+uint64_t histogram_quantile(Histogram* histogram, double quantile) {
+    uint64_t total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        total += histogram->counts[i];
+    }
+    if (!total) {
+        return 0;
+    }
+    uint64_t rank = quantile * total;
+    if (rank >= total) {
+        rank = total - 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen > rank) {
+            return bucket_limit(i);
+        }
+    }
+    return bucket_limit(HISTOGRAM_BUCKETS - 1);
+}
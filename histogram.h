@@ -0,0 +1,27 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+#define HISTOGRAM_SUB_BITS 3   // Buckets per power of two, as a power of two
+#define HISTOGRAM_MAX_BIT  39  // Larger values go in the last bucket
+#define HISTOGRAM_BUCKETS \
+    ((HISTOGRAM_MAX_BIT - HISTOGRAM_SUB_BITS + 2) << HISTOGRAM_SUB_BITS)
+
+// A high dynamic range histogram of non-negative integers, such as
+// nanoseconds. Values below 2^HISTOGRAM_SUB_BITS get a bucket each and every
+// power of two above that is split into 2^HISTOGRAM_SUB_BITS buckets, so any
+// value is recorded to within 1 part in 2^HISTOGRAM_SUB_BITS in constant
+// time and space.
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+} Histogram;
+
+void record_value(Histogram* histogram, uint64_t value);
+void add_histogram(Histogram* total, Histogram* histogram);
+uint64_t bucket_limit(int bucket);
+uint64_t histogram_quantile(Histogram* histogram, double quantile);
+
+#endif  // HISTOGRAM_H
@@ -0,0 +1,298 @@
+#include "metrics.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "buffer.h"
+
+#define METRICS_HOST  "127.0.0.1"  // Metrics are only served locally
+#define REQUEST_LEN   4096
+#define SCRAPE_TIMEOUT 2000  // Milliseconds a scraper has to send and read
+#define NS_PER_SECOND 1e9
+
+typedef struct {
+    ServerDetails* details;
+    int fd;
+} MetricsListener;
+
+void* metrics_thread(void* rawListener);
+void serve_metrics(MetricsListener* listener, int fd);
+bool read_request(int fd, char* request);
+void write_metrics(ServerDetails* details, Buffer* out);
+void write_counter(Buffer* out, char* name, char* help, uint64_t value);
+void write_gauge(Buffer* out, char* name, char* help, long value);
+void write_histogram(Buffer* out, char* name, char* help,
+        Histogram* histogram);
+int listen_queue_depth(ServerDetails* details);
+
+/* start_metrics()
+ * −−−−−−−−−−−−−−−
+ * Listens on details->metricsPort of the loopback address and starts a
+ * thread that answers every HTTP request on it with the server's metrics
+ * in the Prometheus text format. Sessions start timing their guesses once
+ * this is set.
+ *
+ * Returns: false if the port could not be listened on, otherwise true.
+ */
+bool start_metrics(ServerDetails* details) {
+    int fd = open_listener(METRICS_HOST, details->metricsPort, false);
+    struct sockaddr_in ad;
+    socklen_t len = sizeof(struct sockaddr_in);
+    if (fd < 0 || getsockname(fd, (struct sockaddr*)&ad, &len)) {
+        return false;
+    }
+    fprintf(stderr, "Metrics on %s port %u\n", METRICS_HOST,
+            ntohs(ad.sin_port));
+    fflush(stderr);
+
+    MetricsListener* listener = x_malloc(sizeof(MetricsListener));
+    listener->details = details;
+    listener->fd = fd;
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, metrics_thread, listener)) {
+        free(listener);
+        close(fd);
+        return false;
+    }
+    pthread_detach(tid);
+    return true;
+}
+
+// Serves one scrape at a time, which is all a metrics listener sees.
+void* metrics_thread(void* rawListener) {
+    MetricsListener* listener = rawListener;
+    while (true) {
+        int fd = accept(listener->fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        serve_metrics(listener, fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+/* serve_metrics()
+ * −−−−−−−−−−−−−−−
+ * Reads the request headers, whatever the path, and replies with the
+ * metrics over HTTP/1.0. Scrapes are served one at a time, so a scraper
+ * that does not send its request or read the reply within SCRAPE_TIMEOUT
+ * is dropped rather than holding up the next.
+ */
+void serve_metrics(MetricsListener* listener, int fd) {
+    char request[REQUEST_LEN + 1];
+    struct timeval timeout = {.tv_sec = SCRAPE_TIMEOUT / 1000,
+            .tv_usec = SCRAPE_TIMEOUT % 1000 * 1000};
+    if (!read_request(fd, request)
+            || setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                    sizeof(timeout))) {
+        return;
+    }
+
+    Buffer body, out;
+    init_buffer(&body);
+    init_buffer(&out);
+    write_metrics(listener->details, &body);
+    buffer_printf(&out, "HTTP/1.0 200 OK\r\n"
+                        "Content-Type: text/plain; version=0.0.4\r\n"
+                        "Content-Length: %zu\r\n\r\n",
+            buffer_used(&body));
+    buffer_append(&out, body.data, buffer_used(&body));
+    while (buffer_used(&out)) {
+        ssize_t size = send(fd, out.data + out.start, buffer_used(&out),
+                MSG_NOSIGNAL);
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size <= 0) {
+            break;
+        }
+        buffer_consume(&out, size);
+    }
+    free_buffer(&body);
+    free_buffer(&out);
+}
+
+/* read_request()
+ * −−−−−−−−−−−−−−−
+ * Reads up to the end of the request headers into request, which holds
+ * REQUEST_LEN bytes and a terminator, waiting at most SCRAPE_TIMEOUT in
+ * all.
+ *
+ * Returns: false if the headers did not all arrive in time, otherwise true.
+ */
+bool read_request(int fd, char* request) {
+    uint64_t deadline = monotonic_ms() + SCRAPE_TIMEOUT;
+    struct pollfd poller = {.fd = fd, .events = POLLIN};
+    size_t len = 0;
+    while (len < REQUEST_LEN) {
+        uint64_t now = monotonic_ms();
+        int ready = now < deadline ? poll(&poller, 1, deadline - now) : 0;
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            return false;
+        }
+        ssize_t size = read(fd, request + len, REQUEST_LEN - len);
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size <= 0) {
+            return false;
+        }
+        len += size;
+        request[len] = 0;
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+            return true;
+        }
+    }
+    return true;
+}
+
+/* write_metrics()
+ * −−−−−−−−−−−−−−−
+ * Sums every statistics shard, reading each without stopping the thread
+ * that owns it, and writes the totals to out.
+ */
+void write_metrics(ServerDetails* details, Buffer* out) {
+    ServerStats* stats = details->stats;
+    StatShard* total = x_calloc(1, sizeof(StatShard));
+    for (int i = 0; i < stats->numShards; i++) {
+        StatShard* shard = &stats->shards[i];
+        total->connected += __atomic_load_n(&shard->connected,
+                __ATOMIC_RELAXED);
+        total->completed += __atomic_load_n(&shard->completed,
+                __ATOMIC_RELAXED);
+        total->won += __atomic_load_n(&shard->won, __ATOMIC_RELAXED);
+        total->lost += __atomic_load_n(&shard->lost, __ATOMIC_RELAXED);
+        total->rejected += __atomic_load_n(&shard->rejected,
+                __ATOMIC_RELAXED);
+        total->timedOut += __atomic_load_n(&shard->timedOut,
+                __ATOMIC_RELAXED);
+        for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+            total->games[len] += __atomic_load_n(&shard->games[len],
+                    __ATOMIC_RELAXED);
+        }
+        total->bytesIn += __atomic_load_n(&shard->bytesIn, __ATOMIC_RELAXED);
+        total->bytesOut += __atomic_load_n(&shard->bytesOut,
+                __ATOMIC_RELAXED);
+        add_histogram(&total->guessTimes, &shard->guessTimes);
+        add_histogram(&total->lookupTimes, &shard->lookupTimes);
+    }
+
+    write_gauge(out, "wordle_clients_connected", "Clients connected now.",
+            total->connected);
+    write_counter(out, "wordle_clients_completed_total",
+            "Clients that have disconnected.", total->completed);
+    write_counter(out, "wordle_clients_rejected_total",
+            "Clients turned away as the server was busy.", total->rejected);
+    write_counter(out, "wordle_clients_timed_out_total",
+            "Clients closed for being idle or out of time.",
+            total->timedOut);
+    write_counter(out, "wordle_games_won_total", "Games won.", total->won);
+    write_counter(out, "wordle_games_lost_total", "Games lost.",
+            total->lost);
+    buffer_printf(out, "# HELP wordle_games_total Games finished, by word "
+                       "length.\n# TYPE wordle_games_total counter\n");
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        if (total->games[len]) {
+            buffer_printf(out, "wordle_games_total{length=\"%d\"} %d\n", len,
+                    total->games[len]);
+        }
+    }
+    write_counter(out, "wordle_received_bytes_total",
+            "Bytes read from clients.", total->bytesIn);
+    write_counter(out, "wordle_sent_bytes_total", "Bytes sent to clients.",
+            total->bytesOut);
+    write_gauge(out, "wordle_worker_queue_depth",
+            "Clients waiting for a worker thread.",
+            __atomic_load_n(&stats->queued, __ATOMIC_RELAXED));
+    write_gauge(out, "wordle_listen_queue_depth",
+            "Connections waiting to be accepted.",
+            listen_queue_depth(details));
+    write_histogram(out, "wordle_guess_seconds",
+            "Time to judge a guess and work out its hint.",
+            &total->guessTimes);
+    write_histogram(out, "wordle_lookup_seconds",
+            "Time to find a guess in the guesses list.",
+            &total->lookupTimes);
+    free(total);
+}
+
+void write_counter(Buffer* out, char* name, char* help, uint64_t value) {
+    buffer_printf(out, "# HELP %s %s\n# TYPE %s counter\n%s %lu\n", name,
+            help, name, name, (unsigned long)value);
+}
+
+void write_gauge(Buffer* out, char* name, char* help, long value) {
+    buffer_printf(out, "# HELP %s %s\n# TYPE %s gauge\n%s %ld\n", name, help,
+            name, name, value);
+}
+
+/* write_histogram()
+ * −−−−−−−−−−−−−−−
+ * Writes a histogram of nanoseconds in seconds, with a cumulative bucket
+ * at each power of two rather than every one recorded, followed by its
+ * median and tail quantiles at the full precision as a separate gauge.
+ */
+void write_histogram(Buffer* out, char* name, char* help,
+        Histogram* histogram) {
+    buffer_printf(out, "# HELP %s %s\n# TYPE %s histogram\n", name, help,
+            name);
+    uint64_t cumulative = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        cumulative += histogram->counts[i];
+        uint64_t limit = bucket_limit(i);
+        // Only the last bucket of each power of two, which ends below the
+        // next one.
+        if (i < HISTOGRAM_BUCKETS - 1 && (limit & (limit + 1))) {
+            continue;
+        }
+        if (i == HISTOGRAM_BUCKETS - 1) {
+            buffer_printf(out, "%s_bucket{le=\"+Inf\"} %lu\n", name,
+                    (unsigned long)cumulative);
+        } else {
+            buffer_printf(out, "%s_bucket{le=\"%g\"} %lu\n", name,
+                    (limit + 1) / NS_PER_SECOND, (unsigned long)cumulative);
+        }
+    }
+    // The buckets are the counts, as histogram->count is read separately
+    // and may not match them while guesses are being recorded.
+    buffer_printf(out, "%s_sum %g\n%s_count %lu\n", name,
+            histogram->sum / NS_PER_SECOND, name, (unsigned long)cumulative);
+
+    double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    buffer_printf(out, "# HELP %s_quantile %s Quantiles to 1 part in %d.\n"
+                       "# TYPE %s_quantile gauge\n",
+            name, help, 1 << HISTOGRAM_SUB_BITS, name);
+    for (int i = 0; i < sizeof(quantiles) / sizeof(double); i++) {
+        buffer_printf(out, "%s_quantile{quantile=\"%g\"} %g\n", name,
+                quantiles[i],
+                histogram_quantile(histogram, quantiles[i]) / NS_PER_SECOND);
+    }
+}
+
+/* listen_queue_depth()
+ * −−−−−−−−−−−−−−−
+ * Returns: the connections the kernel has completed but the server has not
+ * yet accepted, over all its listening sockets. For a listening socket
+ * Linux reports this as tcpi_unacked.
+ */
+int listen_queue_depth(ServerDetails* details) {
+    int numFds = details->mode == MODE_EPOLL ? details->workers : 1;
+    int depth = 0;
+    for (int i = 0; i < numFds; i++) {
+        struct tcp_info info;
+        socklen_t len = sizeof(struct tcp_info);
+        if (!getsockopt(details->listenFds[i], IPPROTO_TCP, TCP_INFO, &info,
+                    &len)) {
+            depth += info.tcpi_unacked;
+        }
+    }
+    return depth;
+}
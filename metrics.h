@@ -0,0 +1,8 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "wordleServer.h"
+
+bool start_metrics(ServerDetails* details);
+
+#endif  // METRICS_H
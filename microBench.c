@@ -0,0 +1,533 @@
+#define _GNU_SOURCE  // CPU affinity
+
+#include <math.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "candidates.h"
+#include "hint.h"
+#include "util.h"
+#include "wordList.h"
+
+#define EXIT_OK        0
+#define EXIT_BAD_USAGE 1
+#define EXIT_FNF       2
+
+#define NUM_QUERIES    4096
+#define MIN_SYNTH_LEN  3
+#define MAX_SYNTH_LEN  9
+#define RUN_SECONDS    0.1
+#define DEFAULT_RUNS   5
+#define MAX_RUNS       1000
+#define BENCH_SEED     1
+#define BENCH_HINTS    3  // Hints given before counting candidates
+#define SUBJECT_BUFFER 256
+#define SYNTH_TEMPLATE "/tmp/wordle-microbench-XXXXXX"
+
+#define CMD_OPTION '-'
+
+// A kernel performs operation i of a benchmark on its data, returning
+// something derived from the result so the work cannot be optimised away.
+typedef size_t (*Kernel)(void* data, size_t i);
+
+// Random words of one length, for the kernels that take a word.
+typedef struct {
+    int wordLen;
+    char** guesses;
+    char** answers;
+    char hint[MAX_SYNTH_LEN + 1];
+} WordData;
+
+typedef struct {
+    char* path;
+    WordList* list;
+    char** queries;
+    int wordLen;  // The most common word length in the list
+    FILE* file;
+    CandidateIndex* index;
+    char** hintGuesses;  // BENCH_HINTS guesses for each query
+    uint32_t* hintPatterns;
+    Rng rng;
+} ListData;
+
+typedef struct {
+    double mean;
+    double stddev;
+    double min;
+    double median;
+    double max;
+} Stats;
+
+typedef struct {
+    int runs;
+    FILE* json;      // Where to write the JSON results, or NULL
+    bool firstJson;  // No result written to json yet
+} Harness;
+
+double now(void);
+bool pin_to_cpu(int cpu);
+char* random_word(int minLen, int maxLen);
+char* make_synthetic_list(int size);
+char** make_queries(WordList* list);
+void free_queries(char** queries);
+bool linear_in_list(WordList* list, char* word);
+size_t hint_kernel(void* data, size_t i);
+size_t parse_kernel(void* data, size_t i);
+size_t in_list_kernel(void* data, size_t i);
+size_t linear_kernel(void* data, size_t i);
+size_t random_word_kernel(void* data, size_t i);
+size_t read_line_kernel(void* data, size_t i);
+size_t load_kernel(void* data, size_t i);
+size_t candidates_kernel(void* data, size_t i);
+void make_hints(ListData* data);
+double time_run(Kernel kernel, void* data);
+int compare_doubles(const void* a, const void* b);
+Stats run_benchmark(Harness* harness, Kernel kernel, void* data);
+void report(Harness* harness, char* kernel, char* subject, size_t words,
+        Stats* stats);
+void bench_words(Harness* harness, int wordLen);
+bool bench_list(Harness* harness, char* path, char* name);
+void usage_exit(void);
+
+/* Wordle Micro Benchmark
+ * −−−−−−−−−−−−−−−
+ * Usage: ./wordle-microbench [-runs n] [-cpu n] [-json file]
+ *                            [-synthetic size] [file ...]
+ *
+ * Times the hot kernels: get_hint() and parse_word() at several word
+ * lengths, and in_list() (against the linear scan it replaced),
+ * get_random_word(), read_line() and init_word_list() for each word list.
+ * Every benchmark is warmed up with one untimed run and then run -runs
+ * times on the -cpu core (by default the first one available), and the
+ * mean, standard deviation, min, median and max operations per second are
+ * printed and, with -json, written to a file.
+ */
+int main(int argc, char** argv) {
+    Harness harness = {.runs = DEFAULT_RUNS, .json = NULL, .firstJson = true};
+    int cpu = -1;
+    int i;
+    for (i = 1; argv[i] && argv[i][0] == CMD_OPTION
+            && strcmp(argv[i], "-synthetic"); i += 2) {
+        if (!argv[i + 1]) {
+            usage_exit();
+        } else if (!strcmp(argv[i], "-runs")) {
+            if (!parse_int(&harness.runs, argv[i + 1]) || harness.runs < 1
+                    || harness.runs > MAX_RUNS) {
+                usage_exit();
+            }
+        } else if (!strcmp(argv[i], "-cpu")) {
+            if (!parse_int(&cpu, argv[i + 1]) || cpu < 0) {
+                usage_exit();
+            }
+        } else if (!strcmp(argv[i], "-json")) {
+            if (!(harness.json = fopen(argv[i + 1], "w"))) {
+                perror(argv[i + 1]);
+                return EXIT_FNF;
+            }
+        } else {
+            usage_exit();
+        }
+    }
+    if (!pin_to_cpu(cpu)) {
+        fprintf(stderr, "wordle-microbench: unable to run on cpu %d\n", cpu);
+        return EXIT_BAD_USAGE;
+    }
+    if (harness.json) {
+        fprintf(harness.json, "{\"runs\": %d, \"run_seconds\": %g, "
+                              "\"cpu\": %d, \"results\": [",
+                harness.runs, RUN_SECONDS, sched_getcpu());
+    }
+    srand(BENCH_SEED);
+    printf("%-16s %-24s %10s %16s %8s %16s %16s\n", "kernel", "subject",
+            "words", "mean ops/s", "stddev", "min", "max");
+
+    for (int len = MIN_SYNTH_LEN; len <= MAX_SYNTH_LEN; len += 2) {
+        bench_words(&harness, len);
+    }
+
+    int status = EXIT_OK;
+    bool ranOne = false;
+    for (; argv[i] && status == EXIT_OK; i++) {
+        int synthetic = 0;
+        if (argv[i][0] == CMD_OPTION) {
+            if (!argv[i + 1] || strcmp(argv[i], "-synthetic")
+                    || !parse_int(&synthetic, argv[++i]) || synthetic < 1) {
+                usage_exit();
+            }
+            char* path = make_synthetic_list(synthetic);
+            char name[sizeof("synthetic-") + 12];
+            sprintf(name, "synthetic-%d", synthetic);
+            if (!bench_list(&harness, path, name)) {
+                status = EXIT_FNF;
+            }
+            unlink(path);
+            free(path);
+        } else if (!bench_list(&harness, argv[i], argv[i])) {
+            status = EXIT_FNF;
+        }
+        ranOne = true;
+    }
+    if (!ranOne && !bench_list(&harness, "default-answers.txt",
+                           "default-answers.txt")) {
+        status = EXIT_FNF;
+    }
+
+    if (harness.json) {
+        fprintf(harness.json, "\n]}\n");
+        fclose(harness.json);
+    }
+    return status;
+}
+
+double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* pin_to_cpu()
+ * −−−−−−−−−−−−−−−
+ * Keeps the benchmark on one core so runs are not disturbed by migrations,
+ * by default the first core it is allowed to run on.
+ *
+ * Returns: false if cpu is not one of those cores, otherwise true.
+ */
+bool pin_to_cpu(int cpu) {
+    cpu_set_t cpus;
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &cpus)) {
+        return true;  // Run unpinned rather than not at all
+    }
+    if (cpu < 0) {
+        while (!CPU_ISSET(++cpu, &cpus)) {
+        }
+    } else if (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &cpus)) {
+        return false;
+    }
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return !sched_setaffinity(0, sizeof(cpu_set_t), &cpus);
+}
+
+char* random_word(int minLen, int maxLen) {
+    int len = minLen + rand() % (maxLen - minLen + 1);
+    char* word = x_malloc(len + 1);
+    for (int i = 0; i < len; i++) {
+        word[i] = 'a' + rand() % 26;
+    }
+    word[len] = 0;
+    return word;
+}
+
+/* make_synthetic_list()
+ * −−−−−−−−−−−−−−−
+ * Writes size random lowercase words to a temporary file.
+ *
+ * Returns: the path of the file, which the caller must unlink and free.
+ */
+char* make_synthetic_list(int size) {
+    char* path = x_strdup(SYNTH_TEMPLATE);
+    int fd = mkstemp(path);
+    FILE* file = fd < 0 ? NULL : fdopen(fd, "w");
+    if (!file) {
+        perror("mkstemp");
+        exit(EXIT_FNF);
+    }
+    for (int i = 0; i < size; i++) {
+        char* word = random_word(MIN_SYNTH_LEN, MAX_SYNTH_LEN);
+        fprintf(file, "%s\n", word);
+        free(word);
+    }
+    fclose(file);
+    return path;
+}
+
+/* make_queries()
+ * −−−−−−−−−−−−−−−
+ * Builds a NULL terminated query set where half the words are taken from
+ * the list (hits) and half are random strings (almost always misses).
+ */
+char** make_queries(WordList* list) {
+    char** queries = x_malloc(sizeof(char*) * (NUM_QUERIES + 1));
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        int len = MIN_SYNTH_LEN + rand() % (MAX_SYNTH_LEN - MIN_SYNTH_LEN + 1);
+        if (i % 2 && count_words(list, len)) {
+            queries[i] = x_strdup(
+                    get_word(list, len, rand() % count_words(list, len)));
+        } else {
+            queries[i] = random_word(MIN_SYNTH_LEN, MAX_SYNTH_LEN);
+        }
+    }
+    queries[NUM_QUERIES] = NULL;
+    return queries;
+}
+
+void free_queries(char** queries) {
+    for (int i = 0; queries[i]; i++) {
+        free(queries[i]);
+    }
+    free(queries);
+}
+
+/* linear_in_list()
+ * −−−−−−−−−−−−−−−
+ * The original linear scan in_list(), kept as the benchmark baseline.
+ */
+bool linear_in_list(WordList* list, char* word) {
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        for (size_t i = 0; i < count_words(list, len); i++) {
+            if (!strcmp(word, get_word(list, len, i))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t hint_kernel(void* data, size_t i) {
+    WordData* words = data;
+    return get_hint(words->guesses[i % NUM_QUERIES],
+            words->answers[i % NUM_QUERIES], words->wordLen, words->hint);
+}
+
+size_t parse_kernel(void* data, size_t i) {
+    WordData* words = data;
+    return parse_word(words->guesses[i % NUM_QUERIES], words->wordLen);
+}
+
+size_t in_list_kernel(void* data, size_t i) {
+    ListData* list = data;
+    return in_list(list->list, list->queries[i % NUM_QUERIES]);
+}
+
+size_t linear_kernel(void* data, size_t i) {
+    ListData* list = data;
+    return linear_in_list(list->list, list->queries[i % NUM_QUERIES]);
+}
+
+size_t random_word_kernel(void* data, size_t i) {
+    ListData* list = data;
+    return (size_t)get_random_word(list->list, list->wordLen, &list->rng,
+            NULL);
+}
+
+// Reads the next line of the list, starting over at the end.
+size_t read_line_kernel(void* data, size_t i) {
+    ListData* list = data;
+    char* line = read_line(list->file);
+    if (!line) {
+        rewind(list->file);
+        line = read_line(list->file);
+    }
+    size_t len = line ? strlen(line) : 0;
+    free(line);
+    return len;
+}
+
+size_t load_kernel(void* data, size_t i) {
+    ListData* list = data;
+    WordList* loaded = init_word_list(list->path);
+    size_t size = loaded ? loaded->size : 0;
+    free_word_list(loaded);
+    return size;
+}
+
+/* time_run()
+ * −−−−−−−−−−−−−−−
+ * Repeatedly runs kernel for about RUN_SECONDS, checking the clock after
+ * batches that double in size so that neither fast nor slow kernels spend
+ * much of the run reading it.
+ *
+ * Returns: the number of operations per second.
+ */
+double time_run(Kernel kernel, void* data) {
+    volatile size_t sink = 0;
+    size_t ops = 0, batch = 1;
+    double start = now(), elapsed;
+    do {
+        for (size_t end = ops + batch; ops < end; ops++) {
+            sink += kernel(data, ops);
+        }
+        if (batch < NUM_QUERIES) {
+            batch *= 2;
+        }
+        elapsed = now() - start;
+    } while (elapsed < RUN_SECONDS);
+    return ops / elapsed;
+}
+
+int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* run_benchmark()
+ * −−−−−−−−−−−−−−−
+ * Warms up with one untimed run, so caches, the branch predictor and the
+ * CPU clock settle, then times harness->runs runs.
+ *
+ * Returns: statistics over the runs' operations per second.
+ */
+Stats run_benchmark(Harness* harness, Kernel kernel, void* data) {
+    time_run(kernel, data);
+    double* rates = x_malloc(sizeof(double) * harness->runs);
+    double sum = 0;
+    for (int i = 0; i < harness->runs; i++) {
+        rates[i] = time_run(kernel, data);
+        sum += rates[i];
+    }
+    qsort(rates, harness->runs, sizeof(double), compare_doubles);
+
+    Stats stats = {.mean = sum / harness->runs, .min = rates[0],
+            .max = rates[harness->runs - 1]};
+    int middle = harness->runs / 2;
+    stats.median = harness->runs % 2 ? rates[middle]
+                                     : (rates[middle - 1] + rates[middle]) / 2;
+    double squares = 0;
+    for (int i = 0; i < harness->runs; i++) {
+        squares += (rates[i] - stats.mean) * (rates[i] - stats.mean);
+    }
+    stats.stddev = harness->runs > 1 ? sqrt(squares / (harness->runs - 1)) : 0;
+    free(rates);
+    return stats;
+}
+
+void report(Harness* harness, char* kernel, char* subject, size_t words,
+        Stats* stats) {
+    printf("%-16s %-24s %10zu %16.0f %7.1f%% %16.0f %16.0f\n", kernel,
+            subject, words, stats->mean, 100 * stats->stddev / stats->mean,
+            stats->min, stats->max);
+    fflush(stdout);
+    if (!harness->json) {
+        return;
+    }
+    // Subjects are file names, so escape what JSON requires.
+    fprintf(harness->json, "%s\n  {\"kernel\": \"%s\", \"subject\": \"",
+            harness->firstJson ? "" : ",", kernel);
+    for (char* c = subject; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(harness->json, "\\%c", *c);
+        } else if ((unsigned char)*c < ' ') {
+            fprintf(harness->json, "\\u%04x", *c);
+        } else {
+            fputc(*c, harness->json);
+        }
+    }
+    fprintf(harness->json, "\", \"words\": %zu, \"unit\": \"ops/s\", "
+                           "\"mean\": %.1f, \"stddev\": %.1f, \"min\": %.1f, "
+                           "\"median\": %.1f, \"max\": %.1f}",
+            words, stats->mean, stats->stddev, stats->min, stats->median,
+            stats->max);
+    harness->firstJson = false;
+}
+
+size_t candidates_kernel(void* data, size_t i) {
+    ListData* list = data;
+    size_t query = i % NUM_QUERIES * BENCH_HINTS;
+    return candidates_left(list->index, list->wordLen,
+            list->hintGuesses + query, list->hintPatterns + query,
+            BENCH_HINTS);
+}
+
+/* make_hints()
+ * −−−−−−−−−−−−−−−
+ * Plays BENCH_HINTS random guesses against a random answer for each query,
+ * all from the words of the list's most common length.
+ */
+void make_hints(ListData* data) {
+    size_t count = count_words(data->list, data->wordLen);
+    char hint[MAX_LIST_WORD_LEN + 1];
+    data->hintGuesses = x_malloc(sizeof(char*) * NUM_QUERIES * BENCH_HINTS);
+    data->hintPatterns = x_malloc(
+            sizeof(uint32_t) * NUM_QUERIES * BENCH_HINTS);
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        char* answer = get_word(data->list, data->wordLen, rand() % count);
+        for (int j = i * BENCH_HINTS; j < (i + 1) * BENCH_HINTS; j++) {
+            data->hintGuesses[j] = get_word(data->list, data->wordLen,
+                    rand() % count);
+            data->hintPatterns[j] = get_hint(data->hintGuesses[j], answer,
+                    data->wordLen, hint);
+        }
+    }
+}
+
+// Benchmarks the kernels that work on single words of length wordLen.
+void bench_words(Harness* harness, int wordLen) {
+    WordData words = {.wordLen = wordLen};
+    words.guesses = x_malloc(sizeof(char*) * NUM_QUERIES);
+    words.answers = x_malloc(sizeof(char*) * NUM_QUERIES);
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        words.guesses[i] = random_word(wordLen, wordLen);
+        words.answers[i] = random_word(wordLen, wordLen);
+    }
+    char subject[sizeof("length-") + 12];
+    sprintf(subject, "length-%d", wordLen);
+
+    Stats stats = run_benchmark(harness, hint_kernel, &words);
+    report(harness, "get_hint", subject, 0, &stats);
+    stats = run_benchmark(harness, parse_kernel, &words);
+    report(harness, "parse_word", subject, 0, &stats);
+
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        free(words.guesses[i]);
+        free(words.answers[i]);
+    }
+    free(words.guesses);
+    free(words.answers);
+}
+
+bool bench_list(Harness* harness, char* path, char* name) {
+    ListData data = {.path = path, .list = init_word_list(path)};
+    data.file = fopen(path, "r");
+    if (!data.list || !data.file) {
+        free_word_list(data.list);
+        if (data.file) {
+            fclose(data.file);
+        }
+        return false;
+    }
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        if (count_words(data.list, len) > count_words(data.list, data.wordLen)) {
+            data.wordLen = len;
+        }
+    }
+    data.queries = make_queries(data.list);
+    seed_rng(&data.rng, BENCH_SEED, 0);
+    size_t size = data.list->size;
+
+    Stats stats = run_benchmark(harness, in_list_kernel, &data);
+    report(harness, "in_list", name, size, &stats);
+    stats = run_benchmark(harness, linear_kernel, &data);
+    report(harness, "linear_in_list", name, size, &stats);
+    stats = run_benchmark(harness, random_word_kernel, &data);
+    report(harness, "get_random_word", name, size, &stats);
+    stats = run_benchmark(harness, read_line_kernel, &data);
+    report(harness, "read_line", name, size, &stats);
+    stats = run_benchmark(harness, load_kernel, &data);
+    report(harness, "init_word_list", name, size, &stats);
+
+    if (data.wordLen <= MAX_PATTERN_LEN) {
+        data.index = init_candidate_index(data.list, data.wordLen);
+        make_hints(&data);
+        char subject[SUBJECT_BUFFER];
+        snprintf(subject, sizeof(subject), "%s length-%d", name,
+                data.wordLen);
+        stats = run_benchmark(harness, candidates_kernel, &data);
+        report(harness, "candidates_left", subject,
+                count_words(data.list, data.wordLen), &stats);
+        free(data.hintGuesses);
+        free(data.hintPatterns);
+        free_candidate_index(data.index);
+    }
+
+    fclose(data.file);
+    free_queries(data.queries);
+    free_word_list(data.list);
+    return true;
+}
+
+void usage_exit(void) {
+    fprintf(stderr, "Usage: wordle-microbench [-runs n] [-cpu n] [-json file] "
+                    "[-synthetic size] [file ...]\n");
+    exit(EXIT_BAD_USAGE);
+}
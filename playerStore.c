@@ -0,0 +1,528 @@
+#include "playerStore.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#define LOG_NAME      "players.log"
+#define SNAPSHOT_NAME "players.snapshot"
+#define TEMP_NAME     "players.snapshot.tmp"
+
+#define SNAPSHOT_MAGIC   0x59414c50454c4457ull  // "WDLEPLAY"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_RECORDS (1 << 20)  // Log records that trigger a snapshot
+#define INITIAL_PLAYERS  1024       // A power of two
+#define REPLAY_CHUNK     4096       // Log records read at a time
+#define RETRY_SECONDS    1
+
+#define FNV64_OFFSET_BASIS 14695981039346656037ull
+#define FNV64_PRIME        1099511628211ull
+
+// One game in the log, in the order the games finished.
+typedef struct {
+    uint64_t lsn;  // Numbers the records from 1
+    char name[MAX_PLAYER_NAME + 1];
+    uint8_t wordLen;
+    uint8_t guesses;    // Taken to win, or 0 for a loss
+    uint32_t checksum;  // Of the bytes before it, to find a torn write
+} LogRecord;
+
+// Starts a snapshot, and is followed by count PlayerStats.
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t playerSize;  // sizeof(PlayerStats), which must match
+    uint64_t lsn;         // The last log record included
+    uint64_t count;
+    uint64_t checksum;  // Of the players that follow
+} SnapshotHeader;
+
+void free_player_store(PlayerStore* store);
+char* join_path(char* dir, char* name);
+uint64_t checksum_bytes(uint64_t hash, void* data, size_t size);
+uint32_t record_checksum(LogRecord* record);
+bool valid_record(LogRecord* record);
+void init_player_table(PlayerTable* table, size_t capacity);
+void copy_player_table(PlayerTable* to, PlayerTable* from);
+PlayerStats* find_player_slot(PlayerTable* table, char* name);
+PlayerStats* add_player(PlayerTable* table, char* name);
+void grow_players(PlayerTable* table);
+void apply_game(PlayerStats* player, int wordLen, int guesses);
+bool load_snapshot(PlayerStore* store);
+bool replay_log(PlayerStore* store);
+void* log_writer(void* rawStore);
+uint64_t apply_records(PlayerTable* table, Buffer* records);
+void commit_records(PlayerStore* store, Buffer* records);
+bool compact_log(PlayerStore* store, PlayerTable* table, uint64_t lsn);
+bool write_snapshot(PlayerStore* store, PlayerTable* table, uint64_t lsn);
+bool sync_dir(char* dir);
+
+/* open_player_store()
+ * −−−−−−−−−−−−−−−
+ * Recovers the player profiles kept in the directory dir, from the latest
+ * snapshot and the games logged since, dropping a record torn by a crash
+ * from the end of the log. Then starts the thread that writes the log.
+ *
+ * Returns: the store, or NULL if the profiles could not be recovered.
+ */
+PlayerStore* open_player_store(char* dir) {
+    PlayerStore* store = x_calloc(1, sizeof(PlayerStore));
+    store->dir = dir;
+    store->logPath = join_path(dir, LOG_NAME);
+    store->snapshotPath = join_path(dir, SNAPSHOT_NAME);
+    store->tempPath = join_path(dir, TEMP_NAME);
+    init_player_table(&store->profiles, INITIAL_PLAYERS);
+    store->logFd = open(store->logPath, O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (store->logFd < 0) {
+        perror(store->logPath);
+        free_player_store(store);
+        return NULL;
+    }
+    if (!load_snapshot(store) || !replay_log(store)) {
+        free_player_store(store);
+        return NULL;
+    }
+    copy_player_table(&store->committed, &store->profiles);
+    init_buffer(&store->pending);
+    pthread_mutex_init(&store->lock, NULL);
+    pthread_cond_init(&store->ready, NULL);
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, log_writer, store)) {
+        free_player_store(store);
+        return NULL;
+    }
+    pthread_detach(tid);
+    return store;
+}
+
+void free_player_store(PlayerStore* store) {
+    if (store->logFd >= 0) {
+        close(store->logFd);
+    }
+    free(store->profiles.players);
+    free(store->committed.players);
+    free(store->logPath);
+    free(store->snapshotPath);
+    free(store->tempPath);
+    free(store);
+}
+
+char* join_path(char* dir, char* name) {
+    size_t size = strlen(dir) + strlen(name) + 2;
+    char* path = x_malloc(size);
+    snprintf(path, size, "%s/%s", dir, name);
+    return path;
+}
+
+// Continues a 64-bit FNV-1a hash over size bytes of data.
+uint64_t checksum_bytes(uint64_t hash, void* data, size_t size) {
+    unsigned char* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+uint32_t record_checksum(LogRecord* record) {
+    return checksum_bytes(FNV64_OFFSET_BASIS, record,
+            offsetof(LogRecord, checksum));
+}
+
+bool valid_record(LogRecord* record) {
+    return record->checksum == record_checksum(record)
+            && !record->name[MAX_PLAYER_NAME]
+            && valid_player_name(record->name)
+            && record->wordLen <= MAX_LIST_WORD_LEN
+            && record->guesses <= MAX_PLAYER_GUESSES;
+}
+
+// Returns: whether name is 1 to MAX_PLAYER_NAME letters, digits, - or _.
+bool valid_player_name(char* name) {
+    size_t len = strlen(name);
+    if (!len || len > MAX_PLAYER_NAME) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '-'
+                && name[i] != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* find_player()
+ * −−−−−−−−−−−−−−−
+ * Copies the profile of the named player into stats, or a new empty one
+ * if they have not played before.
+ *
+ * Returns: whether the player has played before.
+ */
+bool find_player(PlayerStore* store, char* name, PlayerStats* stats) {
+    pthread_mutex_lock(&store->lock);
+    PlayerStats* player = find_player_slot(&store->profiles, name);
+    bool found = player->name[0];
+    if (found) {
+        *stats = *player;
+    }
+    pthread_mutex_unlock(&store->lock);
+    if (!found) {
+        memset(stats, 0, sizeof(PlayerStats));
+        strncpy(stats->name, name, MAX_PLAYER_NAME);
+    }
+    return found;
+}
+
+/* record_player_game()
+ * −−−−−−−−−−−−−−−
+ * Adds a game of length wordLen to the named player's profile, won in the
+ * given number of guesses or lost if that is 0, and copies the updated
+ * profile into stats unless it is NULL. The game is appended to the log in
+ * memory, and is on disk once the writer's next group commit finishes, so
+ * the caller never waits for the disk.
+ */
+void record_player_game(PlayerStore* store, char* name, int wordLen,
+        int guesses, PlayerStats* stats) {
+    LogRecord record;
+    memset(&record, 0, sizeof(LogRecord));
+    strncpy(record.name, name, MAX_PLAYER_NAME);
+    record.wordLen = wordLen;
+    record.guesses = guesses;
+
+    pthread_mutex_lock(&store->lock);
+    record.lsn = ++store->lsn;
+    record.checksum = record_checksum(&record);
+    PlayerStats* player = add_player(&store->profiles, name);
+    apply_game(player, wordLen, guesses);
+    if (stats) {
+        *stats = *player;
+    }
+    // The writer only waits when there was nothing to write.
+    if (!buffer_used(&store->pending)) {
+        pthread_cond_signal(&store->ready);
+    }
+    buffer_append(&store->pending, (char*)&record, sizeof(LogRecord));
+    pthread_mutex_unlock(&store->lock);
+}
+
+void init_player_table(PlayerTable* table, size_t capacity) {
+    table->players = x_calloc(capacity, sizeof(PlayerStats));
+    table->capacity = capacity;
+    table->count = 0;
+}
+
+void copy_player_table(PlayerTable* to, PlayerTable* from) {
+    to->players = x_malloc(sizeof(PlayerStats) * from->capacity);
+    memcpy(to->players, from->players, sizeof(PlayerStats) * from->capacity);
+    to->capacity = from->capacity;
+    to->count = from->count;
+}
+
+/* find_player_slot()
+ * −−−−−−−−−−−−−−−
+ * Returns: the slot holding the named player, or the free slot where they
+ * would go.
+ */
+PlayerStats* find_player_slot(PlayerTable* table, char* name) {
+    size_t mask = table->capacity - 1;
+    size_t i = checksum_bytes(FNV64_OFFSET_BASIS, name, strlen(name)) & mask;
+    while (table->players[i].name[0]
+            && strcmp(table->players[i].name, name)) {
+        i = (i + 1) & mask;
+    }
+    return &table->players[i];
+}
+
+// Returns: the named player's slot, taking a free one if they are new.
+PlayerStats* add_player(PlayerTable* table, char* name) {
+    PlayerStats* player = find_player_slot(table, name);
+    if (player->name[0]) {
+        return player;
+    }
+    // Kept at most half full, so probes stay short.
+    if (table->count + 1 > table->capacity / 2) {
+        grow_players(table);
+        player = find_player_slot(table, name);
+    }
+    strncpy(player->name, name, MAX_PLAYER_NAME);
+    table->count++;
+    return player;
+}
+
+void grow_players(PlayerTable* table) {
+    PlayerStats* old = table->players;
+    size_t oldCapacity = table->capacity;
+    init_player_table(table, oldCapacity * 2);
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i].name[0]) {
+            *add_player(table, old[i].name) = old[i];
+        }
+    }
+    free(old);
+}
+
+void apply_game(PlayerStats* player, int wordLen, int guesses) {
+    player->played++;
+    player->lengthPlayed[wordLen]++;
+    player->guesses[guesses]++;
+    if (guesses) {
+        player->won++;
+        player->lengthWon[wordLen]++;
+        player->streak++;
+        if (player->streak > player->maxStreak) {
+            player->maxStreak = player->streak;
+        }
+    } else {
+        player->streak = 0;
+    }
+}
+
+/* load_snapshot()
+ * −−−−−−−−−−−−−−−
+ * Reads the players in the store's snapshot, if there is one, setting
+ * store->lsn to the last log record it includes.
+ *
+ * Returns: false if there is a snapshot that cannot be read, otherwise
+ * true.
+ */
+bool load_snapshot(PlayerStore* store) {
+    FILE* file = fopen(store->snapshotPath, "r");
+    if (!file) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        perror(store->snapshotPath);
+        return false;
+    }
+    SnapshotHeader header;
+    bool ok = fread(&header, sizeof(SnapshotHeader), 1, file) == 1
+            && header.magic == SNAPSHOT_MAGIC
+            && header.version == SNAPSHOT_VERSION
+            && header.playerSize == sizeof(PlayerStats);
+    uint64_t checksum = FNV64_OFFSET_BASIS;
+    PlayerStats player;
+    for (uint64_t i = 0; ok && i < header.count; i++) {
+        if (!(ok = fread(&player, sizeof(PlayerStats), 1, file) == 1
+                    && !player.name[MAX_PLAYER_NAME]
+                    && valid_player_name(player.name))) {
+            break;
+        }
+        checksum = checksum_bytes(checksum, &player, sizeof(PlayerStats));
+        *add_player(&store->profiles, player.name) = player;
+    }
+    fclose(file);
+    if (!ok || checksum != header.checksum) {
+        fprintf(stderr, "%s: not a valid snapshot\n", store->snapshotPath);
+        return false;
+    }
+    store->lsn = header.lsn;
+    return true;
+}
+
+/* replay_log()
+ * −−−−−−−−−−−−−−−
+ * Applies the games logged after the snapshot. Anything after the last
+ * whole and intact record was torn by a crash during a write, and is cut
+ * off so new records follow on from the good ones.
+ *
+ * Returns: false if the log could not be read or repaired, otherwise true.
+ */
+bool replay_log(PlayerStore* store) {
+    size_t chunk = sizeof(LogRecord) * REPLAY_CHUNK;
+    char* data = x_malloc(chunk);
+    size_t have = 0;
+    off_t good = 0;
+    bool torn = false;
+    ssize_t size = 0;
+    while (!torn && (size = read(store->logFd, data + have, chunk - have))
+            > 0) {
+        have += size;
+        size_t used = 0;
+        for (; have - used >= sizeof(LogRecord); used += sizeof(LogRecord)) {
+            LogRecord* record = (LogRecord*)(data + used);
+            if (!valid_record(record)) {
+                torn = true;
+                break;
+            }
+            if (record->lsn > store->lsn) {
+                apply_game(add_player(&store->profiles, record->name),
+                        record->wordLen, record->guesses);
+                store->lsn = record->lsn;
+            }
+            good += sizeof(LogRecord);
+        }
+        memmove(data, data + used, have - used);
+        have -= used;
+    }
+    free(data);
+    off_t end = lseek(store->logFd, 0, SEEK_END);
+    if (size < 0 || end < 0) {
+        perror(store->logPath);
+        return false;
+    }
+    if (end > good) {
+        fprintf(stderr, "%s: dropping %ld bytes after the last whole game\n",
+                store->logPath, (long)(end - good));
+        if (ftruncate(store->logFd, good) || fsync(store->logFd)) {
+            perror(store->logPath);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* log_writer()
+ * −−−−−−−−−−−−−−−
+ * Writes the log records appended in memory to the log file, a batch at a
+ * time: the games that finish while one batch is written and synced are
+ * committed together in the next. Each batch is also applied to the
+ * store's committed profiles, and after every SNAPSHOT_RECORDS records
+ * these are compacted into a snapshot, so games are never held up behind
+ * a copy of every profile. A compaction that fails is retried once
+ * another SNAPSHOT_RECORDS records have been logged.
+ */
+void* log_writer(void* rawStore) {
+    PlayerStore* store = rawStore;
+    Buffer writing;
+    init_buffer(&writing);
+    off_t logSize = lseek(store->logFd, 0, SEEK_END);
+    uint64_t logged = logSize > 0 ? logSize / sizeof(LogRecord) : 0;
+    uint64_t compactAt = SNAPSHOT_RECORDS;
+    pthread_mutex_lock(&store->lock);
+    while (true) {
+        while (!buffer_used(&store->pending)) {
+            pthread_cond_wait(&store->ready, &store->lock);
+        }
+        Buffer swap = store->pending;
+        store->pending = writing;
+        writing = swap;
+        pthread_mutex_unlock(&store->lock);
+
+        logged += buffer_used(&writing) / sizeof(LogRecord);
+        uint64_t lsn = apply_records(&store->committed, &writing);
+        commit_records(store, &writing);
+        if (logged >= compactAt) {
+            if (compact_log(store, &store->committed, lsn)) {
+                logged = 0;
+                compactAt = SNAPSHOT_RECORDS;
+            } else {
+                compactAt = logged + SNAPSHOT_RECORDS;
+            }
+        }
+        pthread_mutex_lock(&store->lock);
+    }
+    return NULL;
+}
+
+// Applies the games in records to table, leaving records unconsumed.
+// Returns: the number of the last record.
+uint64_t apply_records(PlayerTable* table, Buffer* records) {
+    LogRecord* record = (LogRecord*)(records->data + records->start);
+    LogRecord* end = (LogRecord*)(records->data + records->start
+            + buffer_used(records));
+    uint64_t lsn = 0;
+    for (; record < end; record++) {
+        apply_game(add_player(table, record->name), record->wordLen,
+                record->guesses);
+        lsn = record->lsn;
+    }
+    return lsn;
+}
+
+// Appends the records to the log file and waits for them to reach the
+// disk, retrying until they do.
+void commit_records(PlayerStore* store, Buffer* records) {
+    while (buffer_used(records)) {
+        ssize_t size = write(store->logFd, records->data + records->start,
+                buffer_used(records));
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size < 0) {
+            perror(store->logPath);
+            sleep(RETRY_SECONDS);
+            continue;
+        }
+        buffer_consume(records, size);
+    }
+    while (fdatasync(store->logFd)) {
+        perror(store->logPath);
+        sleep(RETRY_SECONDS);
+    }
+}
+
+/* compact_log()
+ * −−−−−−−−−−−−−−−
+ * Replaces the snapshot with one of the players in table, which include
+ * every record in the log, then empties the log. A crash in between leaves
+ * a snapshot and a log of records it already includes, which are skipped.
+ *
+ * Returns: whether the log was compacted.
+ */
+bool compact_log(PlayerStore* store, PlayerTable* table, uint64_t lsn) {
+    if (!write_snapshot(store, table, lsn)) {
+        return false;
+    }
+    if (ftruncate(store->logFd, 0) || fsync(store->logFd)) {
+        perror(store->logPath);
+        return false;
+    }
+    return true;
+}
+
+/* write_snapshot()
+ * −−−−−−−−−−−−−−−
+ * Writes the players in table to a new file and renames it over the
+ * snapshot once it is on disk, so there is always a whole snapshot.
+ *
+ * Returns: false if the snapshot could not be written, otherwise true.
+ */
+bool write_snapshot(PlayerStore* store, PlayerTable* table, uint64_t lsn) {
+    PlayerStats* players = table->players;
+    size_t capacity = table->capacity;
+    SnapshotHeader header = {.magic = SNAPSHOT_MAGIC,
+            .version = SNAPSHOT_VERSION,
+            .playerSize = sizeof(PlayerStats),
+            .lsn = lsn,
+            .count = table->count,
+            .checksum = FNV64_OFFSET_BASIS};
+    for (size_t i = 0; i < capacity; i++) {
+        if (players[i].name[0]) {
+            header.checksum = checksum_bytes(header.checksum, &players[i],
+                    sizeof(PlayerStats));
+        }
+    }
+    FILE* file = fopen(store->tempPath, "w");
+    if (!file) {
+        perror(store->tempPath);
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(SnapshotHeader), 1, file) == 1;
+    for (size_t i = 0; ok && i < capacity; i++) {
+        if (players[i].name[0]) {
+            ok = fwrite(&players[i], sizeof(PlayerStats), 1, file) == 1;
+        }
+    }
+    ok = ok && !fflush(file) && !fsync(fileno(file));
+    ok = !fclose(file) && ok;
+    if (!ok || rename(store->tempPath, store->snapshotPath)
+            || !sync_dir(store->dir)) {
+        perror(store->tempPath);
+        unlink(store->tempPath);
+        return false;
+    }
+    return true;
+}
+
+// Makes the renames in a directory durable.
+bool sync_dir(char* dir) {
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = !fsync(fd);
+    close(fd);
+    return ok;
+}
@@ -0,0 +1,60 @@
+#ifndef PLAYER_STORE_H
+#define PLAYER_STORE_H
+
+#include <pthread.h>
+
+#include "buffer.h"
+#include "protocol.h"
+#include "util.h"
+#include "wordList.h"
+
+#define MAX_PLAYER_NAME    FRAME_WORD_LEN  // So binary clients can log in
+#define MAX_PLAYER_GUESSES 10  // At least the server's MAX_TRIES
+
+// Everything kept about a player, all of it derived from their games.
+typedef struct {
+    char name[MAX_PLAYER_NAME + 1];  // Empty for a free slot
+    int played;
+    int won;
+    int streak;
+    int maxStreak;
+    // Games by the guesses each win took, with losses counted at 0
+    int guesses[MAX_PLAYER_GUESSES + 1];
+    int lengthPlayed[MAX_LIST_WORD_LEN + 1];  // Games by word length
+    int lengthWon[MAX_LIST_WORD_LEN + 1];
+} PlayerStats;
+
+// Player profiles, open addressed by name.
+typedef struct {
+    PlayerStats* players;
+    size_t capacity;  // A power of two
+    size_t count;
+} PlayerTable;
+
+// Player profiles, kept in memory and made durable by an append-only log
+// of their games that a writer thread commits in groups. Once the log has
+// grown long enough the writer compacts it into a snapshot of every
+// profile.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;  // Signalled when the log has records to write
+    PlayerTable profiles;
+    // The profiles as of the records committed so far, kept by the writer
+    // alone so it can snapshot them without holding the lock.
+    PlayerTable committed;
+    Buffer pending;  // Records not yet given to the writer
+    uint64_t lsn;    // Number of the last record appended
+    int logFd;
+    char* logPath;
+    char* snapshotPath;
+    char* tempPath;  // Snapshots are written here and renamed into place
+    char* dir;
+} PlayerStore;
+
+PlayerStore* open_player_store(char* dir);
+bool valid_player_name(char* name);
+bool find_player(PlayerStore* store, char* name, PlayerStats* stats);
+void record_player_game(PlayerStore* store, char* name, int wordLen,
+        int guesses, PlayerStats* stats);
+
+#endif  // PLAYER_STORE_H
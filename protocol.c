@@ -0,0 +1,35 @@
+#include "protocol.h"
+
+/* encode_frame()
+ * −−−−−−−−−−−−−−−
+ * Writes frame to bytes, FRAME_LEN bytes in wire order. Words longer than
+ * FRAME_WORD_LEN are cut short.
+ */
+void encode_frame(Frame* frame, char* bytes) {
+    memset(bytes, 0, FRAME_LEN);
+    bytes[0] = frame->code;
+    bytes[1] = frame->arg;
+    bytes[2] = frame->triesLeft;
+    bytes[3] = frame->streak;
+    bytes[4] = frame->pattern & 0xff;
+    bytes[5] = frame->pattern >> 8;
+    memcpy(bytes + 6, frame->word, strnlen(frame->word, FRAME_WORD_LEN));
+}
+
+// Sets the frame's word, cutting it short at FRAME_WORD_LEN letters.
+void set_frame_word(Frame* frame, char* word) {
+    size_t len = strnlen(word, FRAME_WORD_LEN);
+    memcpy(frame->word, word, len);
+    frame->word[len] = 0;
+}
+
+void decode_frame(char* bytes, Frame* frame) {
+    unsigned char* raw = (unsigned char*)bytes;
+    frame->code = raw[0];
+    frame->arg = raw[1];
+    frame->triesLeft = raw[2];
+    frame->streak = raw[3];
+    frame->pattern = raw[4] | raw[5] << 8;
+    memcpy(frame->word, bytes + 6, FRAME_WORD_LEN);
+    frame->word[FRAME_WORD_LEN] = 0;
+}
@@ -0,0 +1,68 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+
+#include "util.h"
+
+// The binary protocol. A client selects it by sending a FRAME_LEN byte
+// OP_HELLO frame as the very first bytes of the connection; the server
+// answers with a STATUS_HELLO frame after the welcome text it has already
+// sent, which the client skips by reading up to the first NUL byte. From
+// then on every request gets exactly one reply, both FRAME_LEN bytes:
+//
+//   byte 0      opcode (client) or status (server)
+//   byte 1      argument: a word length or number of tries
+//   byte 2      tries left in the current game (server)
+//   byte 3      win streak, at most 255 (server)
+//   bytes 4-5   hint pattern, little endian (see HINT_CORRECT) (server)
+//   bytes 6-15  a word, NUL padded
+#define FRAME_LEN       16
+#define FRAME_WORD_LEN  10
+#define PROTOCOL_VERSION 1
+
+// Requests, mirroring the options of the text menu.
+#define OP_HELLO      0  // Switch to the binary protocol
+#define OP_PLAY       1  // Start a game
+#define OP_WORD_LEN   2  // Set the word length to the argument
+#define OP_TRIES      3  // Set the number of tries to the argument
+#define OP_CHEAT      4  // Set the next answer to the word, or clear it
+#define OP_EXIT       5
+#define OP_GUESS      6  // Guess the word
+#define OP_PROBE      7  // Hint for the word without using a try (-batch)
+#define OP_CANDIDATES 8  // Count the answers still possible
+#define OP_LOGIN      9  // Play as the player named by the word (-players)
+
+// Replies.
+#define STATUS_HELLO       0  // Argument is PROTOCOL_VERSION
+#define STATUS_OK          1  // Argument is the word length
+#define STATUS_STARTED     2  // Argument is the word length
+#define STATUS_HINT        3
+#define STATUS_WON         4
+#define STATUS_LOST        5  // Word is the answer
+#define STATUS_NOT_LETTERS 6
+#define STATUS_BAD_LENGTH  7
+#define STATUS_NOT_WORD    8  // Guess is not in the dictionary
+#define STATUS_NO_ANSWERS  9  // Argument is the word length asked for
+#define STATUS_BAD_VALUE   10
+#define STATUS_BAD_OP      11  // Unknown, or not allowed in this state
+#define STATUS_BYE         12
+#define STATUS_CANDIDATES  13  // Word is the count, in decimal
+#define STATUS_TIMED_OUT   14  // Unprompted, then closed; word is the answer
+                               // if a game was lost
+#define STATUS_LOGGED_IN   15  // Argument is games played, at most 255
+
+typedef struct {
+    uint8_t code;
+    uint8_t arg;
+    uint8_t triesLeft;
+    uint8_t streak;
+    uint16_t pattern;
+    char word[FRAME_WORD_LEN + 1];
+} Frame;
+
+void encode_frame(Frame* frame, char* bytes);
+void decode_frame(char* bytes, Frame* frame);
+void set_frame_word(Frame* frame, char* word);
+
+#endif  // PROTOCOL_H
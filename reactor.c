@@ -0,0 +1,471 @@
+#define _GNU_SOURCE  // accept4(), CPU affinity
+
+#include "reactor.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "session.h"
+#include "slab.h"
+#include "timerWheel.h"
+
+#define MAX_EVENTS   256
+#define READ_CHUNK   4096
+#define TIMER_TICK   100  // Milliseconds
+#define CONNECTION_CHUNK   256
+#define MAX_SPARE_BUFFERS  64
+#define MAX_SPARE_CAPACITY (4 * MAX_LINE_LEN)
+
+// A client served by the reactor. Only input that does not yet make up a
+// whole line and replies the socket would not take are kept per client, so
+// idle clients cost little more than their Session. Connections and their
+// buffers are recycled by the reactor, so once it has served its busiest
+// moment it serves clients without touching the heap.
+typedef struct Connection {
+    int fd;  // Or -1 once closed
+    uint32_t events;  // Events currently registered with epoll
+    Session session;
+    Buffer partial;   // Start of the next line
+    Buffer unsent;    // Replies still to be written
+    Timer timer;      // Due at the earlier of its idle and game deadlines
+    uint64_t deadline;
+    struct Connection* nextClosed;  // See Reactor.closed
+} Connection;
+
+typedef struct {
+    int epollFd;
+    int listenFd;
+    int spareFd;  // Given up to accept and drop clients when out of fds
+    int cpu;      // Core to run on, or -1 for any
+    ServerDetails* details;
+    StatShard* stats;
+    Buffer out;   // Replies to the client currently being served
+    TimerWheel timers;  // In ticks of TIMER_TICK milliseconds
+    Slab connections;
+    // Closed during the current batch of events, which may still hold
+    // events for them, so freed only once the batch is done.
+    Connection* closed;
+    Buffer spares[MAX_SPARE_BUFFERS];  // Emptied client buffers for reuse
+    int numSpares;
+    char in[READ_CHUNK];
+} Reactor;
+
+void* reactor_thread(void* rawReactor);
+void pin_to_cpu(int cpu);
+bool set_nonblocking(int fd);
+void accept_clients(Reactor* reactor);
+void shed_client(Reactor* reactor);
+void serve_client(Reactor* reactor, Connection* conn, uint32_t events);
+bool read_client(Reactor* reactor, Connection* conn);
+bool process_input(Reactor* reactor, Connection* conn, char* data,
+        size_t size);
+bool flush_client(Reactor* reactor, Connection* conn);
+bool watch_client(Reactor* reactor, Connection* conn);
+void lend_buffer(Reactor* reactor, Buffer* buf);
+void recycle_buffer(Reactor* reactor, Buffer* buf);
+void reset_deadline(Reactor* reactor, Connection* conn);
+void expire_client(Timer* timer, void* rawReactor);
+void close_client(Reactor* reactor, Connection* conn);
+void free_closed_clients(Reactor* reactor);
+
+/* run_reactors()
+ * −−−−−−−−−−−−−−−
+ * Starts one epoll reactor per worker, each with its own listening socket
+ * and statistics shard and pinned to its own core where there are enough,
+ * running the last one on this thread. Never returns unless epoll fails.
+ */
+void run_reactors(ServerDetails* details, ServerStats* stats) {
+    raise_fd_limit();
+    cpu_set_t cpus;
+    int numCpus = 0;
+    if (!sched_getaffinity(0, sizeof(cpu_set_t), &cpus)) {
+        numCpus = CPU_COUNT(&cpus);
+    }
+
+    Reactor* reactors = x_calloc(details->workers, sizeof(Reactor));
+    int cpu = -1;
+    for (int i = 0; i < details->workers; i++) {
+        Reactor* reactor = &reactors[i];
+        reactor->details = details;
+        reactor->stats = &stats->shards[i];
+        reactor->listenFd = details->listenFds[i];
+        reactor->spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        init_buffer(&reactor->out);
+        init_timer_wheel(&reactor->timers, monotonic_ms() / TIMER_TICK);
+        init_slab(&reactor->connections, sizeof(Connection),
+                CONNECTION_CHUNK);
+
+        // Pin only when every reactor can have a core to itself.
+        reactor->cpu = -1;
+        if (details->workers > 1 && details->workers <= numCpus) {
+            do {
+                cpu++;
+            } while (!CPU_ISSET(cpu, &cpus));
+            reactor->cpu = cpu;
+        }
+    }
+
+    pthread_t tid;
+    for (int i = 0; i < details->workers - 1; i++) {
+        if (pthread_create(&tid, NULL, reactor_thread, &reactors[i])) {
+            perror("pthread_create");
+            return;
+        }
+        pthread_detach(tid);
+    }
+    reactor_thread(&reactors[details->workers - 1]);
+}
+
+/* reactor_thread()
+ * −−−−−−−−−−−−−−−
+ * Serves the clients of one reactor with an epoll event loop over
+ * non-blocking sockets. Each client's Session is driven by whole lines as
+ * they arrive, and its replies are written without blocking. While any
+ * client has a deadline the loop wakes every TIMER_TICK to expire them,
+ * after serving the batch of events so a client that has just sent
+ * something is not timed out.
+ */
+void* reactor_thread(void* rawReactor) {
+    Reactor* reactor = rawReactor;
+    if (reactor->cpu >= 0) {
+        pin_to_cpu(reactor->cpu);
+    }
+
+    reactor->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+    if (reactor->epollFd < 0 || !set_nonblocking(reactor->listenFd)
+            || epoll_ctl(reactor->epollFd, EPOLL_CTL_ADD, reactor->listenFd,
+                    &event)) {
+        perror("reactor_thread");
+        return NULL;
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (true) {
+        int numEvents = epoll_wait(reactor->epollFd, events, MAX_EVENTS,
+                reactor->timers.count ? TIMER_TICK : -1);
+        if (numEvents < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            return NULL;
+        }
+        for (int i = 0; i < numEvents; i++) {
+            // The listening socket is the only one without a Connection.
+            if (!events[i].data.ptr) {
+                accept_clients(reactor);
+            } else {
+                serve_client(reactor, events[i].data.ptr, events[i].events);
+            }
+        }
+        expire_timers(&reactor->timers, monotonic_ms() / TIMER_TICK,
+                expire_client, reactor);
+        free_closed_clients(reactor);
+    }
+    return NULL;
+}
+
+void pin_to_cpu(int cpu) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+}
+
+bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    return flags >= 0 && !fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+void accept_clients(Reactor* reactor) {
+    while (true) {
+        int fd = accept4(reactor->listenFd, NULL, NULL,
+                SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EMFILE || errno == ENFILE) {
+                shed_client(reactor);
+                continue;
+            }
+            // EAGAIN once the backlog is empty, other errors are dropped
+            // connections that the next event will move past.
+            return;
+        }
+        Connection* conn = slab_alloc(&reactor->connections);
+        conn->fd = fd;
+        init_buffer(&conn->partial);
+        init_buffer(&conn->unsent);
+        client_connected(reactor->stats);
+        start_session(&conn->session, reactor->details, reactor->stats,
+                &reactor->out);
+        if (!flush_client(reactor, conn) || !watch_client(reactor, conn)) {
+            close_client(reactor, conn);
+        } else {
+            reset_deadline(reactor, conn);
+        }
+    }
+}
+
+/* shed_client()
+ * −−−−−−−−−−−−−−−
+ * Out of file descriptors, so use the spare one to accept the next client
+ * and close it straight away. Otherwise it would sit in the backlog and
+ * the listening socket would stay readable, spinning the loop.
+ */
+void shed_client(Reactor* reactor) {
+    if (reactor->spareFd < 0) {
+        return;
+    }
+    close(reactor->spareFd);
+    int fd = accept(reactor->listenFd, NULL, NULL);
+    if (fd >= 0) {
+        close(fd);
+        increment_stat(&reactor->stats->rejected);
+    }
+    reactor->spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+void serve_client(Reactor* reactor, Connection* conn, uint32_t events) {
+    if (conn->fd < 0) {
+        return;
+    }
+    bool ok = true;
+    if (events & EPOLLOUT) {
+        ok = flush_client(reactor, conn);
+    }
+    // Only read once earlier replies are written, so a client that does
+    // not read cannot make the server buffer without limit.
+    if (ok && events & (EPOLLIN | EPOLLHUP | EPOLLERR)
+            && !buffer_used(&conn->unsent)) {
+        ok = read_client(reactor, conn) && flush_client(reactor, conn);
+    }
+    if (!ok || (conn->session.state == SESSION_CLOSED
+                       && !buffer_used(&conn->unsent))
+            || !watch_client(reactor, conn)) {
+        close_client(reactor, conn);
+    } else {
+        reset_deadline(reactor, conn);
+    }
+}
+
+/* read_client()
+ * −−−−−−−−−−−−−−−
+ * Reads what the client has sent, at most READ_CHUNK bytes so one busy
+ * client cannot starve the rest, and feeds it to the client's Session.
+ *
+ * Returns: false if the connection failed or the client sent a line longer
+ * than MAX_LINE_LEN, otherwise true.
+ */
+bool read_client(Reactor* reactor, Connection* conn) {
+    ssize_t size;
+    TRACE_BEGIN(TRACE_READ, conn->session.id);
+    do {
+        size = read(conn->fd, reactor->in, READ_CHUNK);
+    } while (size < 0 && errno == EINTR);
+    TRACE_END(TRACE_READ, conn->session.id);
+
+    if (size > 0) {
+        add_bytes(&reactor->stats->bytesIn, size);
+        return process_input(reactor, conn, reactor->in, size);
+    }
+    if (size < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    end_session(&conn->session, &conn->partial);
+    return true;
+}
+
+/* process_input()
+ * −−−−−−−−−−−−−−−
+ * Feeds the complete lines or frames in data to the client's Session,
+ * straight from data unless the start of the first arrived in an earlier
+ * read.
+ *
+ * Returns: false if the unfinished line is longer than MAX_LINE_LEN,
+ * otherwise true.
+ */
+bool process_input(Reactor* reactor, Connection* conn, char* data,
+        size_t size) {
+    Buffer view = {.data = data, .len = size, .capacity = size};
+    Buffer* lines = &view;
+    if (buffer_used(&conn->partial)) {
+        buffer_append(&conn->partial, data, size);
+        lines = &conn->partial;
+    }
+    feed_session(&conn->session, lines);
+    if (conn->session.state == SESSION_CLOSED) {
+        recycle_buffer(reactor, &conn->partial);
+        return true;
+    }
+    if (lines == &view) {
+        if (buffer_used(&view)) {
+            lend_buffer(reactor, &conn->partial);
+            buffer_append(&conn->partial, view.data + view.start,
+                    buffer_used(&view));
+        }
+    } else if (!buffer_used(&conn->partial)) {
+        recycle_buffer(reactor, &conn->partial);
+    } else {
+        buffer_compact(&conn->partial);
+    }
+    return buffer_used(&conn->partial) <= MAX_LINE_LEN;
+}
+
+/* flush_client()
+ * −−−−−−−−−−−−−−−
+ * Writes as much of the client's replies as the socket will take, keeping
+ * the rest in conn->unsent until the socket is writable again.
+ *
+ * Returns: false if the connection failed, otherwise true.
+ */
+bool flush_client(Reactor* reactor, Connection* conn) {
+    Buffer* out = &reactor->out;
+    if (buffer_used(&conn->unsent)) {
+        buffer_append(&conn->unsent, out->data + out->start,
+                buffer_used(out));
+        buffer_consume(out, buffer_used(out));
+        out = &conn->unsent;
+    }
+    while (buffer_used(out)) {
+        TRACE_BEGIN(TRACE_SEND, conn->session.id);
+        ssize_t size = send(conn->fd, out->data + out->start,
+                buffer_used(out), MSG_NOSIGNAL);
+        TRACE_END(TRACE_SEND, conn->session.id);
+        if (size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                buffer_consume(out, buffer_used(out));
+                return false;
+            }
+            break;
+        }
+        buffer_consume(out, size);
+        add_bytes(&reactor->stats->bytesOut, size);
+    }
+    if (out == &reactor->out && buffer_used(out)) {
+        lend_buffer(reactor, &conn->unsent);
+        buffer_append(&conn->unsent, out->data + out->start,
+                buffer_used(out));
+        buffer_consume(out, buffer_used(out));
+    } else if (out != &reactor->out && !buffer_used(out)) {
+        recycle_buffer(reactor, out);
+    }
+    return true;
+}
+
+/* watch_client()
+ * −−−−−−−−−−−−−−−
+ * Registers interest in the client becoming writable while it has unsent
+ * replies, and in it becoming readable otherwise.
+ *
+ * Returns: false if epoll refused, otherwise true.
+ */
+bool watch_client(Reactor* reactor, Connection* conn) {
+    uint32_t events = buffer_used(&conn->unsent) ? EPOLLOUT : EPOLLIN;
+    if (events == conn->events) {
+        return true;
+    }
+    struct epoll_event event = {.events = events, .data.ptr = conn};
+    int op = conn->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(reactor->epollFd, op, conn->fd, &event)) {
+        return false;
+    }
+    conn->events = events;
+    return true;
+}
+
+// Gives an empty client buffer a spare's storage, if there is one.
+void lend_buffer(Reactor* reactor, Buffer* buf) {
+    if (!buf->data && reactor->numSpares) {
+        *buf = reactor->spares[--reactor->numSpares];
+    }
+}
+
+/* recycle_buffer()
+ * −−−−−−−−−−−−−−−
+ * Takes the storage of a client buffer that has been emptied, keeping it
+ * for the next client buffer that needs some unless there are plenty of
+ * spares already or it grew unusually large.
+ */
+void recycle_buffer(Reactor* reactor, Buffer* buf) {
+    if (!buf->data) {
+        return;
+    }
+    if (reactor->numSpares == MAX_SPARE_BUFFERS
+            || buf->capacity > MAX_SPARE_CAPACITY) {
+        free_buffer(buf);
+        return;
+    }
+    buf->start = buf->len = 0;
+    reactor->spares[reactor->numSpares++] = *buf;
+    init_buffer(buf);
+}
+
+/* reset_deadline()
+ * −−−−−−−−−−−−−−−
+ * Restarts the client's idle deadline after it has been served, and
+ * schedules its timer for whichever of that and its game's comes first.
+ */
+void reset_deadline(Reactor* reactor, Connection* conn) {
+    conn->deadline = session_deadline(&conn->session, monotonic_ms());
+    if (!conn->deadline) {
+        cancel_timer(&reactor->timers, &conn->timer);
+        return;
+    }
+    schedule_timer(&reactor->timers, &conn->timer,
+            (conn->deadline + TIMER_TICK - 1) / TIMER_TICK);
+}
+
+/* expire_client()
+ * −−−−−−−−−−−−−−−
+ * Times out the client whose timer expired, sending it what it can of
+ * the reason before disconnecting it. Timers the wheel had to cut short
+ * are rescheduled.
+ */
+void expire_client(Timer* timer, void* rawReactor) {
+    Reactor* reactor = rawReactor;
+    Connection* conn = (Connection*)((char*)timer
+            - offsetof(Connection, timer));
+    if (monotonic_ms() < conn->deadline) {
+        schedule_timer(&reactor->timers, &conn->timer,
+                (conn->deadline + TIMER_TICK - 1) / TIMER_TICK);
+        return;
+    }
+    time_out_session(&conn->session);
+    flush_client(reactor, conn);
+    close_client(reactor, conn);
+}
+
+/* close_client()
+ * −−−−−−−−−−−−−−−
+ * Disconnects a client. Its Connection is only returned to the slab by
+ * free_closed_clients(), as the current batch of events may refer to it.
+ */
+void close_client(Reactor* reactor, Connection* conn) {
+    // Closing the socket also removes it from the epoll set.
+    cancel_timer(&reactor->timers, &conn->timer);
+    close(conn->fd);
+    conn->fd = -1;
+    close_session(&conn->session);
+    recycle_buffer(reactor, &conn->partial);
+    recycle_buffer(reactor, &conn->unsent);
+    conn->nextClosed = reactor->closed;
+    reactor->closed = conn;
+    client_disconnected(reactor->stats);
+}
+
+// Frees the Connections closed since the batch of events began.
+void free_closed_clients(Reactor* reactor) {
+    while (reactor->closed) {
+        Connection* conn = reactor->closed;
+        reactor->closed = conn->nextClosed;
+        slab_free(&reactor->connections, conn);
+    }
+}
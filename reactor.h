@@ -0,0 +1,8 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include "wordleServer.h"
+
+void run_reactors(ServerDetails* details, ServerStats* stats);
+
+#endif  // REACTOR_H
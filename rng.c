@@ -0,0 +1,79 @@
+#include "rng.h"
+
+#include <stdio.h>
+#include <sys/random.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SPLITMIX_GAMMA 0x9e3779b97f4a7c15ull
+
+uint64_t mix64(uint64_t x);
+uint64_t rotate_left(uint64_t x, int bits);
+
+/* random_seed()
+ * −−−−−−−−−−−−−−−
+ * Returns: a seed read from the kernel's random source, or if that fails,
+ * one made from the time and process ID.
+ */
+uint64_t random_seed(void) {
+    uint64_t seed;
+    if (getrandom(&seed, sizeof(seed), 0) == sizeof(seed)) {
+        return seed;
+    }
+    perror("getrandom");
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return mix64(now.tv_sec * 1000000000ull + now.tv_nsec) ^ getpid();
+}
+
+/* seed_rng()
+ * −−−−−−−−−−−−−−−
+ * Seeds rng with the stream'th of the independent sequences belonging to
+ * seed, so that one seed can start any number of generators.
+ */
+void seed_rng(Rng* rng, uint64_t seed, uint64_t stream) {
+    // SplitMix64, as recommended by the xoshiro authors.
+    uint64_t x = seed ^ mix64(stream * SPLITMIX_GAMMA);
+    for (int i = 0; i < 4; i++) {
+        x += SPLITMIX_GAMMA;
+        rng->s[i] = mix64(x);
+    }
+}
+
+uint64_t mix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+uint64_t rotate_left(uint64_t x, int bits) {
+    return (x << bits) | (x >> (64 - bits));
+}
+
+uint64_t next_random(Rng* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rotate_left(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotate_left(s[3], 45);
+    return result;
+}
+
+/* random_below()
+ * −−−−−−−−−−−−−−−
+ * Draws uniformly from 0 to bound - 1, which must be at least 1. Draws
+ * below 2^64 mod bound are rejected so that every remainder is equally
+ * likely, which needs a second draw less than once in 2^64 / bound tries.
+ */
+uint64_t random_below(Rng* rng, uint64_t bound) {
+    uint64_t threshold = -bound % bound;
+    uint64_t x;
+    do {
+        x = next_random(rng);
+    } while (x < threshold);
+    return x % bound;
+}
@@ -0,0 +1,17 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// A xoshiro256** generator. Each thread or session owns one, so drawing a
+// number needs no locking and no shared state.
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+uint64_t random_seed(void);
+void seed_rng(Rng* rng, uint64_t seed, uint64_t stream);
+uint64_t next_random(Rng* rng);
+uint64_t random_below(Rng* rng, uint64_t bound);
+
+#endif  // RNG_H
@@ -0,0 +1,945 @@
+#include "session.h"
+
+#include "hint.h"
+#include "protocol.h"
+
+#define WORD_LEN_MSG "Enter the word length"
+#define TRIES_MSG    "Enter the number of tries"
+
+#define BATCH_PREFIX '?'   // Starts a batch of guesses that cost no tries
+#define BATCH_DELIMS " ,"
+#define CANDIDATES_COMMAND "!"  // Asks how many answers are still possible
+
+// The fixed parts of the replies, copied as they are rather than formatted.
+static const char welcomeText[] =
+        "Welcome to...\n"
+        " _    _               _ _      \n"
+        "| |  | |             | | |     \n"
+        "| |  | | ___  _ __ __| | | ___ \n"
+        "| |/\\| |/ _ \\| '__/ _` | |/ _ \\\n"
+        "\\  /\\  / (_) | | | (_| | |  __/\n"
+        " \\/  \\/ \\___/|_|  \\__,_|_|\\___|\n\n";
+static const char menuHead[] = "Select one of the following:\n";
+static const char menuTail[] =
+        "2. Change word length\n"
+        "3. Change number of tries\n"
+        "4. Cheat and set the answer\n"
+        "5. Exit\n";
+
+// The outcome of a guess in the current game.
+typedef enum {
+    GUESS_NOT_LETTERS,
+    GUESS_BAD_LENGTH,
+    GUESS_NOT_FOUND,  // Not in the guesses list
+    GUESS_WRONG,      // Costs a try, except in a batch
+    GUESS_CORRECT,
+} GuessResult;
+
+void process_line(Session* session, char* line);
+void process_frame(Session* session, char* bytes);
+void process_binary_guess(Session* session, char* guess, bool probe,
+        Frame* reply);
+void process_binary_login(Session* session, char* name, Frame* reply);
+void send_frame(Session* session, Frame* reply);
+void print_welcome(Session* session);
+void print_menu(Session* session);
+void print_prompt(Session* session);
+void print_no_answers(Session* session, int wordLen);
+void process_option(Session* session, char* line);
+void prompt_int(Session* session, char* msg, int min, int max);
+bool process_int(Session* session, char* line, int* dest, char* msg, int min,
+        int max);
+void set_word_len(Session* session, int wordLen);
+void process_cheat(Session* session, char* line);
+void process_login(Session* session, char* line);
+bool log_in(Session* session, char* name, PlayerStats* stats);
+void print_player(Session* session, PlayerStats* stats);
+void refresh_dictionary(Session* session);
+bool change_word_len(Session* session, int wordLen);
+WordStatus change_answer(Session* session, char* word);
+void start_game(Session* session);
+bool begin_game(Session* session);
+void process_guess(Session* session, char* guess);
+void process_batch(Session* session, char* guesses);
+GuessResult judge_guess(Session* session, char* guess, uint32_t* pattern,
+        size_t* guessPos);
+GuessResult grade_guess(Session* session, char* guess, uint32_t* pattern,
+        size_t* guessPos);
+bool lookup_guess(Session* session, char* guess, size_t* guessPos);
+uint32_t fill_hint(Session* session, char* guess, size_t guessPos);
+void use_try(Session* session, size_t guessPos, uint32_t pattern);
+size_t count_left(Session* session);
+void finish_game(Session* session, bool won);
+void record_game(Session* session, bool won);
+int guesses_taken(Session* session, bool won);
+void count_daily(Session* session, bool won);
+void print_daily(Session* session);
+
+/* start_session()
+ * −−−−−−−−−−−−−−−
+ * Sets up a new client's session and greets them with the menu.
+ */
+void start_session(Session* session, ServerDetails* details,
+        StatShard* stats, Buffer* out) {
+    memset(session, 0, sizeof(Session));
+    session->details = details;
+    session->dictionary = acquire_dictionary(details->dictionaries);
+    session->stats = stats;
+    session->out = out;
+    // Each session draws its own sequence of the server's seed.
+    session->id = __atomic_fetch_add(&details->sessions, 1, __ATOMIC_RELAXED);
+    seed_rng(&session->rng, details->seed, session->id);
+    session->wordLen = DEFAULT_WORD_LEN;
+    session->tries = DEFAULT_TRIES;
+    session->answerPos = -1;
+    session->puzzle = -1;
+    print_welcome(session);
+    print_menu(session);
+}
+
+/* feed_session()
+ * −−−−−−−−−−−−−−−
+ * Handles and consumes every complete line in in, or every complete frame
+ * once the client has chosen the binary protocol by starting with an
+ * OP_HELLO frame. Lines are modified in place.
+ */
+void feed_session(Session* session, Buffer* in) {
+    TRACE_BEGIN(TRACE_FEED, session->id);
+    if (session->protocol == PROTOCOL_UNKNOWN && buffer_used(in)) {
+        session->protocol = in->data[in->start] == OP_HELLO ? PROTOCOL_BINARY
+                                                            : PROTOCOL_TEXT;
+    }
+    if (session->protocol == PROTOCOL_BINARY) {
+        while (session->state != SESSION_CLOSED
+                && buffer_used(in) >= FRAME_LEN) {
+            process_frame(session, in->data + in->start);
+            buffer_consume(in, FRAME_LEN);
+        }
+    } else {
+        char* line;
+        while (session->state != SESSION_CLOSED
+                && (line = buffer_line(in))) {
+            process_line(session, line);
+        }
+    }
+    TRACE_END(TRACE_FEED, session->id);
+}
+
+/* end_session()
+ * −−−−−−−−−−−−−−−
+ * Handles the client closing their end of the connection, feeding any
+ * unterminated last line left in in. A game in progress counts as lost.
+ */
+void end_session(Session* session, Buffer* in) {
+    if (session->protocol != PROTOCOL_BINARY
+            && session->state != SESSION_CLOSED && buffer_used(in)) {
+        buffer_append(in, "", 1);
+        process_line(session, in->data + in->start);
+        buffer_consume(in, buffer_used(in));
+    }
+    if (session->state == SESSION_PLAYING) {
+        if (session->protocol == PROTOCOL_BINARY) {
+            record_game(session, false);
+        } else {
+            finish_game(session, false);
+        }
+    }
+    session->state = SESSION_CLOSED;
+}
+
+/* session_deadline()
+ * −−−−−−−−−−−−−−−
+ * Returns: when the session should be timed out (see monotonic_ms()) if
+ * its client sends nothing more from now on, or 0 for never.
+ */
+uint64_t session_deadline(Session* session, uint64_t now) {
+    uint64_t deadline = session->details->idleTimeout
+            ? now + session->details->idleTimeout * 1000ull : 0;
+    if (session->gameDeadline
+            && (!deadline || session->gameDeadline < deadline)) {
+        deadline = session->gameDeadline;
+    }
+    return deadline;
+}
+
+/* time_out_session()
+ * −−−−−−−−−−−−−−−
+ * Ends the session of a client that has been idle too long or run out of
+ * time for its game, which counts as lost, telling it why before it is
+ * disconnected.
+ */
+void time_out_session(Session* session) {
+    if (session->state == SESSION_CLOSED) {
+        return;
+    }
+    bool playing = session->state == SESSION_PLAYING;
+    if (session->protocol == PROTOCOL_BINARY) {
+        Frame reply;
+        memset(&reply, 0, sizeof(Frame));
+        reply.code = STATUS_TIMED_OUT;
+        if (playing) {
+            set_frame_word(&reply, session->answer);
+        }
+        send_frame(session, &reply);
+    } else if (playing) {
+        buffer_printf(session->out, "\nOut of time - the word is \"%s\".\n",
+                session->answer);
+    } else {
+        buffer_printf(session->out, "\nTimed out - goodbye.\n");
+    }
+    if (playing) {
+        record_game(session, false);
+    }
+    increment_stat(&session->stats->timedOut);
+    session->state = SESSION_CLOSED;
+}
+
+// Releases the session's word lists once its client is gone. A game
+// still in progress, as when the connection failed, counts as lost.
+void close_session(Session* session) {
+    if (session->state == SESSION_PLAYING) {
+        record_game(session, false);
+    }
+    session->state = SESSION_CLOSED;
+    release_dictionary(session->dictionary);
+    session->dictionary = NULL;
+}
+
+/* process_line()
+ * −−−−−−−−−−−−−−−
+ * Handles the next line of input from the client, which may be modified.
+ */
+void process_line(Session* session, char* line) {
+    int value;
+    switch (session->state) {
+        case SESSION_MENU:
+            TRACE_BEGIN(TRACE_OPTION, session->id);
+            process_option(session, line);
+            TRACE_END(TRACE_OPTION, session->id);
+            break;
+        case SESSION_WORD_LEN:
+            if (process_int(session, line, &value, WORD_LEN_MSG, MIN_WORD_LEN,
+                        MAX_WORD_LEN)) {
+                set_word_len(session, value);
+            }
+            break;
+        case SESSION_TRIES:
+            if (process_int(session, line, &session->tries, TRIES_MSG,
+                        MIN_TRIES, MAX_TRIES)) {
+                print_menu(session);
+            }
+            break;
+        case SESSION_CHEAT:
+            process_cheat(session, line);
+            break;
+        case SESSION_LOGIN:
+            process_login(session, line);
+            break;
+        case SESSION_PLAYING:
+            process_guess(session, line);
+            break;
+        case SESSION_CLOSED:
+            break;
+    }
+}
+
+/* process_frame()
+ * −−−−−−−−−−−−−−−
+ * Handles the next FRAME_LEN byte request from a binary client, replying
+ * with exactly one frame.
+ */
+void process_frame(Session* session, char* bytes) {
+    Frame request, reply;
+    decode_frame(bytes, &request);
+    memset(&reply, 0, sizeof(Frame));
+    reply.code = STATUS_BAD_OP;
+    bool playing = session->state == SESSION_PLAYING;
+    switch (request.code) {
+        case OP_HELLO:
+            reply.code = STATUS_HELLO;
+            reply.arg = PROTOCOL_VERSION;
+            break;
+        case OP_PLAY:
+            if (!playing) {
+                reply.code = begin_game(session) ? STATUS_STARTED
+                                                 : STATUS_NO_ANSWERS;
+                reply.arg = session->wordLen;
+            }
+            break;
+        case OP_WORD_LEN:
+            if (playing) {
+                break;
+            }
+            reply.arg = request.arg;
+            if (request.arg < MIN_WORD_LEN || request.arg > MAX_WORD_LEN) {
+                reply.code = STATUS_BAD_VALUE;
+            } else {
+                reply.code = change_word_len(session, request.arg)
+                        ? STATUS_OK : STATUS_NO_ANSWERS;
+            }
+            break;
+        case OP_TRIES:
+            if (playing) {
+                break;
+            }
+            reply.code = STATUS_BAD_VALUE;
+            if (request.arg >= MIN_TRIES && request.arg <= MAX_TRIES) {
+                session->tries = request.arg;
+                reply.code = STATUS_OK;
+            }
+            reply.arg = session->tries;
+            break;
+        case OP_CHEAT:
+            if (!playing) {
+                switch (change_answer(session, request.word)) {
+                    case WORD_OK:
+                        reply.code = STATUS_OK;
+                        break;
+                    case WORD_NOT_LETTERS:
+                        reply.code = STATUS_NOT_LETTERS;
+                        break;
+                    case WORD_BAD_LENGTH:
+                        reply.code = STATUS_BAD_LENGTH;
+                        break;
+                }
+                reply.arg = session->wordLen;
+            }
+            break;
+        case OP_EXIT:
+            reply.code = STATUS_BYE;
+            session->state = SESSION_CLOSED;
+            break;
+        case OP_GUESS:
+        case OP_PROBE:
+            if (playing && (request.code == OP_GUESS
+                                   || session->details->maxBatch)) {
+                process_binary_guess(session, request.word,
+                        request.code == OP_PROBE, &reply);
+            }
+            break;
+        case OP_CANDIDATES:
+            if (playing) {
+                reply.code = STATUS_CANDIDATES;
+                snprintf(reply.word, sizeof(reply.word), "%zu",
+                        count_left(session));
+            }
+            break;
+        case OP_LOGIN:
+            if (!playing && session->details->players) {
+                process_binary_login(session, request.word, &reply);
+            }
+            break;
+    }
+    send_frame(session, &reply);
+}
+
+/* process_binary_guess()
+ * −−−−−−−−−−−−−−−
+ * Fills in the reply to a guess, or to a probe, which is answered with a
+ * hint even when correct and costs no tries.
+ */
+void process_binary_guess(Session* session, char* guess, bool probe,
+        Frame* reply) {
+    uint32_t pattern = 0;
+    size_t guessPos;
+    GuessResult result = judge_guess(session, guess, &pattern, &guessPos);
+    if (probe && (result == GUESS_CORRECT || result == GUESS_WRONG)) {
+        reply->code = STATUS_HINT;
+        reply->pattern = pattern;
+        return;
+    }
+    switch (result) {
+        case GUESS_NOT_LETTERS:
+            reply->code = STATUS_NOT_LETTERS;
+            break;
+        case GUESS_BAD_LENGTH:
+            reply->code = STATUS_BAD_LENGTH;
+            break;
+        case GUESS_NOT_FOUND:
+            reply->code = STATUS_NOT_WORD;
+            break;
+        case GUESS_CORRECT:
+            reply->code = STATUS_WON;
+            reply->pattern = pattern;
+            record_game(session, true);
+            break;
+        case GUESS_WRONG:
+            reply->code = STATUS_HINT;
+            reply->pattern = pattern;
+            use_try(session, guessPos, pattern);
+            if (!session->triesLeft) {
+                reply->code = STATUS_LOST;
+                set_frame_word(reply, session->answer);
+                record_game(session, false);
+            }
+            break;
+    }
+}
+
+void process_binary_login(Session* session, char* name, Frame* reply) {
+    PlayerStats stats;
+    if (!log_in(session, name, &stats)) {
+        reply->code = STATUS_BAD_VALUE;
+        return;
+    }
+    reply->code = STATUS_LOGGED_IN;
+    reply->arg = stats.played > UINT8_MAX ? UINT8_MAX : stats.played;
+}
+
+void send_frame(Session* session, Frame* reply) {
+    reply->triesLeft = session->state == SESSION_PLAYING ? session->triesLeft
+                                                         : 0;
+    reply->streak = session->streak > UINT8_MAX ? UINT8_MAX : session->streak;
+    encode_frame(reply, buffer_reserve(session->out, FRAME_LEN));
+    session->out->len += FRAME_LEN;
+}
+
+void print_welcome(Session* session) {
+    buffer_append(session->out, welcomeText, sizeof(welcomeText) - 1);
+}
+
+void print_menu(Session* session) {
+    buffer_append(session->out, menuHead, sizeof(menuHead) - 1);
+    if (session->details->daily && !session->answer[0]) {
+        buffer_printf(session->out, "1. Play game (word length: %d, tries: "
+                                    "%d, answer: daily #%d)\n",
+                session->wordLen, session->tries,
+                current_puzzle(session->details->daily));
+    } else {
+        buffer_printf(session->out,
+                "1. Play game (word length: %d, tries: %d, answer: %s)\n",
+                session->wordLen, session->tries,
+                session->answer[0] ? session->answer : "?????");
+    }
+    buffer_append(session->out, menuTail, sizeof(menuTail) - 1);
+    if (session->player[0]) {
+        buffer_printf(session->out, "6. Log in (playing as %s)\n",
+                session->player);
+    } else if (session->details->players) {
+        buffer_printf(session->out, "6. Log in\n");
+    }
+    session->state = SESSION_MENU;
+}
+
+void print_prompt(Session* session) {
+    if (session->triesLeft <= 0) {
+        return;
+    }
+    buffer_printf(session->out, "Enter a %d letter word ", session->wordLen);
+    if (session->triesLeft == 1) {
+        buffer_printf(session->out, "(last attempt):\n");
+    } else {
+        buffer_printf(session->out, "(%d attempts remaining):\n",
+                session->triesLeft);
+    }
+}
+
+void print_no_answers(Session* session, int wordLen) {
+    buffer_printf(session->out,
+            "No %d letter answers are available - try another length.\n",
+            wordLen);
+}
+
+void process_option(Session* session, char* line) {
+    int option;
+    if (!parse_int(&option, line)) {
+        print_menu(session);
+        return;
+    }
+    switch (option) {
+        case 1:
+            start_game(session);
+            return;
+        case 2:
+            prompt_int(session, WORD_LEN_MSG, MIN_WORD_LEN, MAX_WORD_LEN);
+            session->state = SESSION_WORD_LEN;
+            return;
+        case 3:
+            prompt_int(session, TRIES_MSG, MIN_TRIES, MAX_TRIES);
+            session->state = SESSION_TRIES;
+            return;
+        case 4:
+            buffer_printf(session->out, "Enter the answer word:\n");
+            session->state = SESSION_CHEAT;
+            return;
+        case 5:
+            buffer_printf(session->out, "Goodbye...\n");
+            session->state = SESSION_CLOSED;
+            return;
+        case 6:
+            if (session->details->players) {
+                buffer_printf(session->out, "Enter your player name:\n");
+                session->state = SESSION_LOGIN;
+                return;
+            }
+            break;
+    }
+    print_menu(session);
+}
+
+void prompt_int(Session* session, char* msg, int min, int max) {
+    buffer_printf(session->out, "%s (%d to %d):\n", msg, min, max);
+}
+
+/* process_int()
+ * −−−−−−−−−−−−−−−
+ * Handles the reply to a prompt_int() prompt, prompting again unless the
+ * line is an integer between min and max.
+ *
+ * Returns: true if dest was set, otherwise false.
+ */
+bool process_int(Session* session, char* line, int* dest, char* msg, int min,
+        int max) {
+    int value;
+    if (!parse_int(&value, line) || value < min || value > max) {
+        prompt_int(session, msg, min, max);
+        return false;
+    }
+    *dest = value;
+    return true;
+}
+
+void set_word_len(Session* session, int wordLen) {
+    if (!change_word_len(session, wordLen)) {
+        print_no_answers(session, wordLen);
+    }
+    print_menu(session);
+}
+
+/* change_word_len()
+ * −−−−−−−−−−−−−−−
+ * Returns: false, leaving the word length as it was, if the answers list
+ * has no words of the new length, otherwise true.
+ */
+bool change_word_len(Session* session, int wordLen) {
+    refresh_dictionary(session);
+    if (!count_words(session->dictionary->answers, wordLen)) {
+        return false;
+    }
+    // A cheat answer only makes sense for its own length.
+    if (wordLen != session->wordLen) {
+        session->answer[0] = 0;
+    }
+    session->wordLen = wordLen;
+    return true;
+}
+
+void process_cheat(Session* session, char* line) {
+    if (change_answer(session, line) != WORD_OK) {
+        buffer_printf(session->out, "Answers must be %d to %d letters long "
+                                    "and contain only letters.\n",
+                MIN_WORD_LEN, MAX_WORD_LEN);
+    }
+    print_menu(session);
+}
+
+/* process_login()
+ * −−−−−−−−−−−−−−−
+ * Handles the reply to the login prompt, going back to the menu for an
+ * empty line and prompting again for a name that is not valid.
+ */
+void process_login(Session* session, char* line) {
+    PlayerStats stats;
+    if (line[0] && !log_in(session, line, &stats)) {
+        buffer_printf(session->out, "Player names are 1 to %d letters, "
+                                    "digits, - or _.\n"
+                                    "Enter your player name:\n",
+                MAX_PLAYER_NAME);
+        return;
+    }
+    if (line[0]) {
+        print_player(session, &stats);
+    }
+    print_menu(session);
+}
+
+/* log_in()
+ * −−−−−−−−−−−−−−−
+ * Makes the session play as the named player, taking up their streak, and
+ * copies their profile into stats.
+ *
+ * Returns: false if the name is not a valid player name, otherwise true.
+ */
+bool log_in(Session* session, char* name, PlayerStats* stats) {
+    if (!valid_player_name(name)) {
+        return false;
+    }
+    find_player(session->details->players, name, stats);
+    strcpy(session->player, stats->name);
+    session->streak = stats->streak;
+    return true;
+}
+
+void print_player(Session* session, PlayerStats* stats) {
+    if (!stats->played) {
+        buffer_printf(session->out, "Welcome, %s - your games will be "
+                                    "saved.\n",
+                stats->name);
+        return;
+    }
+    buffer_printf(session->out, "Welcome back, %s: %d played, %d won, win "
+                                "streak %d (best %d)\n",
+            stats->name, stats->played, stats->won, stats->streak,
+            stats->maxStreak);
+    for (int i = 1; i <= MAX_PLAYER_GUESSES; i++) {
+        if (stats->guesses[i]) {
+            buffer_printf(session->out, "Won in %d: %d\n", i,
+                    stats->guesses[i]);
+        }
+    }
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        if (stats->lengthPlayed[len]) {
+            buffer_printf(session->out, "%d letters: %d played, %d won\n",
+                    len, stats->lengthPlayed[len], stats->lengthWon[len]);
+        }
+    }
+}
+
+/* change_answer()
+ * −−−−−−−−−−−−−−−
+ * Sets the answer for the next game, which also sets the word length, so
+ * it must be a length the menu allows. An empty word clears the answer and
+ * restores the default word length.
+ *
+ * Returns: WORD_OK if the answer was set, otherwise why the word is not a
+ * valid answer.
+ */
+WordStatus change_answer(Session* session, char* word) {
+    if (!word[0]) {
+        session->answer[0] = 0;
+        session->wordLen = DEFAULT_WORD_LEN;
+        return WORD_OK;
+    }
+    if (parse_word(word, -1) != WORD_OK) {
+        return WORD_NOT_LETTERS;
+    }
+    size_t len = strlen(word);
+    if (len < MIN_WORD_LEN || len > MAX_WORD_LEN) {
+        return WORD_BAD_LENGTH;
+    }
+    strcpy(session->answer, word);
+    session->wordLen = len;
+    return WORD_OK;
+}
+
+void start_game(Session* session) {
+    if (!begin_game(session)) {
+        print_no_answers(session, session->wordLen);
+        print_menu(session);
+        return;
+    }
+    print_prompt(session);
+}
+
+/* begin_game()
+ * −−−−−−−−−−−−−−−
+ * Starts a game with the cheat answer, or otherwise today's answer in daily
+ * mode or a random answer of the session's word length.
+ *
+ * Returns: false if there is no such answer, otherwise true.
+ */
+bool begin_game(Session* session) {
+    refresh_dictionary(session);
+    WordList* answers = session->dictionary->answers;
+    session->answerPos = -1;
+    session->puzzle = -1;
+    size_t pos;
+    if (!session->answer[0]) {
+        char* answer;
+        if (session->details->daily) {
+            session->puzzle = current_puzzle(session->details->daily);
+            answer = get_daily_word(session->dictionary, session->wordLen,
+                    session->puzzle, &pos);
+        } else {
+            answer = get_random_word(answers, session->wordLen,
+                    &session->rng, &pos);
+        }
+        if (!answer) {
+            return false;
+        }
+        strcpy(session->answer, answer);
+        session->answerPos = pos;
+    } else if (find_word(answers, session->answer, &pos)) {
+        // Cheat answers need not be in the answers list.
+        session->answerPos = pos;
+    }
+    session->triesLeft = session->tries;
+    session->candidatesLeft = -1;
+    session->gameDeadline = session->details->gameTimeout
+            ? monotonic_ms() + session->details->gameTimeout * 1000ull : 0;
+    session->state = SESSION_PLAYING;
+    return true;
+}
+
+/* refresh_dictionary()
+ * −−−−−−−−−−−−−−−
+ * Moves the session on to the latest word lists if they have been reloaded.
+ * Only called between games, so a game is played out with one set of lists.
+ */
+void refresh_dictionary(Session* session) {
+    DictionaryStore* store = session->details->dictionaries;
+    if (session->dictionary
+            != __atomic_load_n(&store->current, __ATOMIC_RELAXED)) {
+        release_dictionary(session->dictionary);
+        session->dictionary = acquire_dictionary(store);
+    }
+}
+
+void process_guess(Session* session, char* guess) {
+    if (guess[0] == BATCH_PREFIX && session->details->maxBatch) {
+        process_batch(session, guess + 1);
+        print_prompt(session);
+        return;
+    } else if (!strcmp(guess, CANDIDATES_COMMAND)) {
+        size_t left = count_left(session);
+        buffer_printf(session->out, "%zu candidate%s left\n", left,
+                left == 1 ? "" : "s");
+        print_prompt(session);
+        return;
+    }
+    uint32_t pattern;
+    size_t guessPos;
+    switch (judge_guess(session, guess, &pattern, &guessPos)) {
+        case GUESS_NOT_LETTERS:
+            buffer_printf(session->out,
+                    "Words must contain only letters - try again.\n");
+            break;
+        case GUESS_BAD_LENGTH:
+            buffer_printf(session->out,
+                    "Words must be %d letters long - try again.\n",
+                    session->wordLen);
+            break;
+        case GUESS_NOT_FOUND:
+            buffer_printf(session->out,
+                    "Word not found in the dictionary - try again.\n");
+            break;
+        case GUESS_WRONG:
+            buffer_printf(session->out, "%s\n", session->hint);
+            use_try(session, guessPos, pattern);
+            break;
+        case GUESS_CORRECT:
+            buffer_printf(session->out, "Correct!\n");
+            finish_game(session, true);
+            return;
+    }
+    if (!session->triesLeft) {
+        finish_game(session, false);
+        return;
+    }
+    print_prompt(session);
+}
+
+/* process_batch()
+ * −−−−−−−−−−−−−−−
+ * Replies to a line of up to maxBatch guesses, separated by spaces or
+ * commas, with a line each giving its hint, or "invalid" when it is not a
+ * word from the guesses list. None of them cost a try, even if correct.
+ */
+void process_batch(Session* session, char* guesses) {
+    uint32_t pattern;
+    size_t guessPos;
+    char* save;
+    char* guess = strtok_r(guesses, BATCH_DELIMS, &save);
+    for (int i = 0; guess && i < session->details->maxBatch; i++) {
+        GuessResult result = judge_guess(session, guess, &pattern,
+                &guessPos);
+        if (result == GUESS_CORRECT || result == GUESS_WRONG) {
+            render_hint(pattern, guess, session->wordLen, session->hint);
+            buffer_printf(session->out, "%s %s\n", guess, session->hint);
+        } else {
+            buffer_printf(session->out, "%s invalid\n", guess);
+        }
+        guess = strtok_r(NULL, BATCH_DELIMS, &save);
+    }
+}
+
+/* judge_guess()
+ * −−−−−−−−−−−−−−−
+ * Checks a guess in the current game, lower casing it in place and setting
+ * session->hint for a wrong guess from the guesses list. While there is a
+ * metrics listener, the time taken is added to the session's statistics.
+ *
+ * Returns: the outcome, with pattern set for correct and wrong guesses and
+ * guessPos set to the position of a wrong guess in the guesses list.
+ */
+GuessResult judge_guess(Session* session, char* guess, uint32_t* pattern,
+        size_t* guessPos) {
+    TRACE_BEGIN(TRACE_GUESS, session->id);
+    GuessResult result;
+    if (!session->details->metricsPort) {
+        result = grade_guess(session, guess, pattern, guessPos);
+    } else {
+        uint64_t start = monotonic_ns();
+        result = grade_guess(session, guess, pattern, guessPos);
+        record_value(&session->stats->guessTimes, monotonic_ns() - start);
+    }
+    TRACE_END(TRACE_GUESS, session->id);
+    return result;
+}
+
+// The untimed judge_guess().
+GuessResult grade_guess(Session* session, char* guess, uint32_t* pattern,
+        size_t* guessPos) {
+    switch (parse_word(guess, session->wordLen)) {
+        case WORD_NOT_LETTERS:
+            return GUESS_NOT_LETTERS;
+        case WORD_BAD_LENGTH:
+            return GUESS_BAD_LENGTH;
+        case WORD_OK:
+            break;
+    }
+    if (!strcmp(guess, session->answer)) {
+        *pattern = 0;
+        for (int i = 0; i < session->wordLen; i++) {
+            *pattern = *pattern * 3 + HINT_CORRECT;
+        }
+        return GUESS_CORRECT;
+    }
+    if (!lookup_guess(session, guess, guessPos)) {
+        return GUESS_NOT_FOUND;
+    }
+    TRACE_BEGIN(TRACE_HINT, session->id);
+    *pattern = fill_hint(session, guess, *guessPos);
+    TRACE_END(TRACE_HINT, session->id);
+    return GUESS_WRONG;
+}
+
+// Finds a guess in the guesses list, timing it as judge_guess() does.
+bool lookup_guess(Session* session, char* guess, size_t* guessPos) {
+    TRACE_BEGIN(TRACE_LOOKUP, session->id);
+    bool found;
+    if (!session->details->metricsPort) {
+        found = find_word(session->dictionary->guesses, guess, guessPos);
+    } else {
+        uint64_t start = monotonic_ns();
+        found = find_word(session->dictionary->guesses, guess, guessPos);
+        record_value(&session->stats->lookupTimes, monotonic_ns() - start);
+    }
+    TRACE_END(TRACE_LOOKUP, session->id);
+    return found;
+}
+
+/* fill_hint()
+ * −−−−−−−−−−−−−−−
+ * Writes the hint for guess into session->hint, looking it up in the
+ * feedback matrix when there is one covering the guess and answer and
+ * computing it otherwise.
+ *
+ * Returns: the hint's pattern id.
+ */
+uint32_t fill_hint(Session* session, char* guess, size_t guessPos) {
+    uint32_t pattern;
+    if (session->dictionary->matrix && session->answerPos >= 0
+            && lookup_pattern(session->dictionary->matrix, session->wordLen,
+                    guessPos, session->answerPos, &pattern)) {
+        render_hint(pattern, guess, session->wordLen, session->hint);
+        return pattern;
+    }
+    return get_hint(guess, session->answer, session->wordLen, session->hint);
+}
+
+// Counts a wrong guess against the tries left, remembering its hint.
+void use_try(Session* session, size_t guessPos, uint32_t pattern) {
+    int used = session->tries - session->triesLeft;
+    session->hintGuesses[used] = guessPos;
+    session->hintPatterns[used] = pattern;
+    session->candidatesLeft = -1;
+    session->triesLeft--;
+}
+
+/* count_left()
+ * −−−−−−−−−−−−−−−
+ * Returns: the number of answers of the game's length that are consistent
+ * with every hint given so far, kept until the next hint.
+ */
+size_t count_left(Session* session) {
+    if (session->candidatesLeft >= 0) {
+        return session->candidatesLeft;
+    }
+    char* guesses[MAX_TRIES];
+    int used = session->tries - session->triesLeft;
+    for (int i = 0; i < used; i++) {
+        guesses[i] = get_word(session->dictionary->guesses, session->wordLen,
+                session->hintGuesses[i]);
+    }
+    session->candidatesLeft = candidates_left(session->dictionary->candidates,
+            session->wordLen, guesses, session->hintPatterns, used);
+    return session->candidatesLeft;
+}
+
+void finish_game(Session* session, bool won) {
+    if (!won) {
+        buffer_printf(session->out, "Bad luck - the word is \"%s\".\n",
+                session->answer);
+    }
+    record_game(session, won);
+    if (session->puzzle >= 0) {
+        print_daily(session);
+    }
+    buffer_printf(session->out, "Win Streak: %d\n\n", session->streak);
+    print_menu(session);
+}
+
+// Counts the game towards the statistics and the streak and ends it.
+void record_game(Session* session, bool won) {
+    StatShard* stats = session->stats;
+    increment_stat(won ? &stats->won : &stats->lost);
+    increment_stat(&stats->games[session->wordLen]);
+    if (session->puzzle >= 0) {
+        count_daily(session, won);
+    }
+    if (session->player[0]) {
+        PlayerStats player;
+        record_player_game(session->details->players, session->player,
+                session->wordLen, guesses_taken(session, won), &player);
+        session->streak = player.streak;
+    } else {
+        session->streak = won ? session->streak + 1 : 0;
+    }
+    session->gameDeadline = 0;
+    session->answer[0] = 0;
+    session->state = SESSION_MENU;
+}
+
+// Adds the game to the daily results, unless this session has already
+// played the same puzzle and word length.
+void count_daily(Session* session, bool won) {
+    if (session->countedPuzzle != session->puzzle) {
+        session->countedPuzzle = session->puzzle;
+        session->countedLengths = 0;
+    }
+    if (session->countedLengths & 1u << session->wordLen) {
+        return;
+    }
+    session->countedLengths |= 1u << session->wordLen;
+    record_daily(session->stats, session->puzzle, session->wordLen,
+            guesses_taken(session, won));
+}
+
+// Returns: the guesses a won game took, or 0 for a lost one.
+int guesses_taken(Session* session, bool won) {
+    return won ? session->tries - session->triesLeft + 1 : 0;
+}
+
+/* print_daily()
+ * −−−−−−−−−−−−−−−
+ * Shows the client how everyone has done at the daily puzzle they just
+ * played, summed over every shard.
+ */
+void print_daily(Session* session) {
+    int results[MAX_TRIES + 1];
+    sum_daily(session->details->stats, session->puzzle, session->wordLen,
+            results);
+    int won = 0, most = session->tries;
+    for (int i = 1; i <= MAX_TRIES; i++) {
+        won += results[i];
+        if (results[i]) {
+            most = i > most ? i : most;
+        }
+    }
+    buffer_printf(session->out, "Daily #%d (%d letters): %d won, %d lost\n",
+            session->puzzle, session->wordLen, won, results[0]);
+    for (int i = 1; i <= most; i++) {
+        buffer_printf(session->out, "%d: %d\n", i, results[i]);
+    }
+}
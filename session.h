@@ -0,0 +1,65 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "buffer.h"
+#include "trace.h"
+#include "wordleServer.h"
+
+#define MAX_LINE_LEN 4096  // Clients sending longer lines are dropped
+
+// What the session is waiting for in the next line from the client.
+typedef enum {
+    SESSION_MENU,      // A menu option
+    SESSION_WORD_LEN,  // A new word length
+    SESSION_TRIES,     // A new number of tries
+    SESSION_CHEAT,     // The answer for the next game
+    SESSION_LOGIN,     // A player name
+    SESSION_PLAYING,   // A guess in the current game
+    SESSION_CLOSED,    // Nothing, the client has left
+} SessionState;
+
+// How the client talks to the server, decided by the first bytes it sends.
+typedef enum {
+    PROTOCOL_UNKNOWN,  // Nothing received yet
+    PROTOCOL_TEXT,     // Menus and prompts, one line per reply
+    PROTOCOL_BINARY,   // Fixed size frames (see protocol.h)
+} SessionProtocol;
+
+// The state of one client's menu and games, driven one line or frame at a
+// time so that it does not care whether the client is served by a blocking
+// thread or an event loop. Replies are appended to out.
+typedef struct {
+    SessionState state;
+    SessionProtocol protocol;
+    ServerDetails* details;
+    Dictionary* dictionary;  // The word lists this game was started with
+    StatShard* stats;
+    Buffer* out;
+    uint64_t id;  // Numbers the sessions the server has started
+    Rng rng;      // Picks the answers
+    int wordLen;
+    int tries;
+    int triesLeft;
+    int streak;  // The player's, once logged in
+    char player[MAX_PLAYER_NAME + 1];  // Logged in as, or empty
+    char answer[MAX_LIST_WORD_LEN + 1];  // Empty unless cheating or playing
+    long answerPos;                      // Position in answers, or -1
+    char hint[MAX_LIST_WORD_LEN + 1];
+    uint32_t hintGuesses[MAX_TRIES];   // Positions in guesses of the wrong
+    uint32_t hintPatterns[MAX_TRIES];  // guesses so far, and their hints
+    long candidatesLeft;               // Answers fitting them, -1 if unknown
+    int puzzle;               // The daily puzzle being played, or -1
+    uint64_t gameDeadline;    // When the game is lost (monotonic_ms()), or 0
+    int countedPuzzle;        // The last daily puzzle played, and a bit for
+    uint32_t countedLengths;  // each word length already counted for it
+} Session;
+
+void start_session(Session* session, ServerDetails* details,
+        StatShard* stats, Buffer* out);
+void feed_session(Session* session, Buffer* in);
+void end_session(Session* session, Buffer* in);
+void close_session(Session* session);
+uint64_t session_deadline(Session* session, uint64_t now);
+void time_out_session(Session* session);
+
+#endif  // SESSION_H
@@ -0,0 +1,39 @@
+#include "slab.h"
+
+#include <string.h>
+
+#include "util.h"
+
+void init_slab(Slab* slab, size_t itemSize, size_t perChunk) {
+    // Round up so every object in a chunk is suitably aligned for anything.
+    size_t align = __BIGGEST_ALIGNMENT__;
+    if (itemSize < sizeof(void*)) {
+        itemSize = sizeof(void*);
+    }
+    slab->itemSize = (itemSize + align - 1) / align * align;
+    slab->perChunk = perChunk;
+    slab->chunk = NULL;
+    slab->chunkUsed = perChunk;
+    slab->freeList = NULL;
+}
+
+void* slab_alloc(Slab* slab) {
+    void* item;
+    if (slab->freeList) {
+        item = slab->freeList;
+        slab->freeList = *(void**)item;
+    } else {
+        if (slab->chunkUsed == slab->perChunk) {
+            slab->chunk = x_malloc(slab->itemSize * slab->perChunk);
+            slab->chunkUsed = 0;
+        }
+        item = slab->chunk + slab->itemSize * slab->chunkUsed++;
+    }
+    memset(item, 0, slab->itemSize);
+    return item;
+}
+
+void slab_free(Slab* slab, void* item) {
+    *(void**)item = slab->freeList;
+    slab->freeList = item;
+}
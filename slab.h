@@ -0,0 +1,22 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+
+// Hands out zeroed objects of one size, carved from chunks of perChunk at
+// a time, and keeps freed ones for reuse. Once it has grown to the most
+// objects ever in use at once it makes no further heap allocations. Chunks
+// are never given back. Not thread-safe.
+typedef struct {
+    size_t itemSize;
+    size_t perChunk;
+    char* chunk;       // The newest chunk, handed out from the front
+    size_t chunkUsed;  // Objects handed out from it so far
+    void* freeList;    // Freed objects, linked through their first bytes
+} Slab;
+
+void init_slab(Slab* slab, size_t itemSize, size_t perChunk);
+void* slab_alloc(Slab* slab);
+void slab_free(Slab* slab, void* item);
+
+#endif  // SLAB_H
@@ -0,0 +1,111 @@
+#include "timerWheel.h"
+
+#define WHEEL_MASK  (WHEEL_SLOTS - 1)
+#define WHEEL_TICKS (1ull << (WHEEL_BITS * WHEEL_LEVELS))
+
+void link_timer(TimerWheel* wheel, Timer* timer);
+void cascade_slot(TimerWheel* wheel, int level, int slot);
+
+void init_timer_wheel(TimerWheel* wheel, uint64_t now) {
+    wheel->now = now;
+    wheel->count = 0;
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+            Timer* head = &wheel->slots[level][slot];
+            head->next = head->prev = head;
+        }
+    }
+}
+
+/* schedule_timer()
+ * −−−−−−−−−−−−−−−
+ * Schedules timer to expire at tick expires, moving it if it was already
+ * scheduled. Ticks already past expire at the next one, and ticks too far
+ * ahead for the wheel expire early, at the furthest it can hold.
+ */
+void schedule_timer(TimerWheel* wheel, Timer* timer, uint64_t expires) {
+    cancel_timer(wheel, timer);
+    if (expires <= wheel->now) {
+        expires = wheel->now + 1;
+    } else if (expires - wheel->now >= WHEEL_TICKS) {
+        expires = wheel->now + WHEEL_TICKS - 1;
+    }
+    timer->expires = expires;
+    link_timer(wheel, timer);
+    wheel->count++;
+}
+
+/* link_timer()
+ * −−−−−−−−−−−−−−−
+ * Puts timer in the lowest level where its expiry and the current tick
+ * only differ within that level's slot index. Its slot is then one the
+ * wheel has yet to reach at that level, rather than one it has passed.
+ */
+void link_timer(TimerWheel* wheel, Timer* timer) {
+    uint64_t differ = timer->expires ^ wheel->now;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1
+            && differ >> (WHEEL_BITS * (level + 1))) {
+        level++;
+    }
+    int slot = (timer->expires >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    Timer* head = &wheel->slots[level][slot];
+    timer->next = head;
+    timer->prev = head->prev;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+void cancel_timer(TimerWheel* wheel, Timer* timer) {
+    if (!timer->next) {
+        return;
+    }
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = timer->prev = NULL;
+    wheel->count--;
+}
+
+// Moves the timers in a slot down to the levels below now that it is due.
+void cascade_slot(TimerWheel* wheel, int level, int slot) {
+    Timer* head = &wheel->slots[level][slot];
+    while (head->next != head) {
+        Timer* timer = head->next;
+        head->next = timer->next;
+        timer->next->prev = head;
+        link_timer(wheel, timer);
+    }
+}
+
+/* expire_timers()
+ * −−−−−−−−−−−−−−−
+ * Advances the wheel to tick now, calling expire for each timer that falls
+ * due on the way. Each timer is unscheduled before its call, which may
+ * schedule or cancel any timer, including it, or free it.
+ */
+void expire_timers(TimerWheel* wheel, uint64_t now, TimerCallback expire,
+        void* arg) {
+    if (!wheel->count && now > wheel->now) {
+        wheel->now = now;
+        return;
+    }
+    while (wheel->now < now) {
+        uint64_t tick = ++wheel->now;
+        // Higher levels first, as they may cascade into this tick's slots.
+        int top = 0;
+        while (top < WHEEL_LEVELS - 1
+                && !(tick & ((1ull << (WHEEL_BITS * (top + 1))) - 1))) {
+            top++;
+        }
+        for (int level = top; level > 0; level--) {
+            cascade_slot(wheel, level,
+                    (tick >> (WHEEL_BITS * level)) & WHEEL_MASK);
+        }
+        Timer* head = &wheel->slots[0][tick & WHEEL_MASK];
+        while (head->next != head) {
+            Timer* timer = head->next;
+            cancel_timer(wheel, timer);
+            expire(timer, arg);
+        }
+    }
+}
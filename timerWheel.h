@@ -0,0 +1,37 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4  // Timers up to 2^24 ticks ahead
+
+// A timer embedded in whatever it times, linked into one slot of a wheel
+// while scheduled.
+typedef struct Timer {
+    struct Timer* next;  // NULL while not scheduled
+    struct Timer* prev;
+    uint64_t expires;    // The tick it is due at
+} Timer;
+
+// A hierarchical timing wheel. Level n has WHEEL_SLOTS slots each spanning
+// WHEEL_SLOTS^n ticks, and timers move down a level each time the wheel
+// reaches the slot they are in, so scheduling, cancelling and expiring a
+// timer each cost O(1) however many there are. Not thread-safe.
+typedef struct {
+    uint64_t now;    // The last tick processed
+    size_t count;    // Timers scheduled
+    Timer slots[WHEEL_LEVELS][WHEEL_SLOTS];  // List heads
+} TimerWheel;
+
+typedef void (*TimerCallback)(Timer* timer, void* arg);
+
+void init_timer_wheel(TimerWheel* wheel, uint64_t now);
+void schedule_timer(TimerWheel* wheel, Timer* timer, uint64_t expires);
+void cancel_timer(TimerWheel* wheel, Timer* timer);
+void expire_timers(TimerWheel* wheel, uint64_t now, TimerCallback expire,
+        void* arg);
+
+#endif  // TIMER_WHEEL_H
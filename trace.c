@@ -0,0 +1,175 @@
+#include "trace.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "util.h"
+
+#define TRACE_RING_SIZE (1 << 13)  // Events kept per thread, a power of two
+#define TRACE_PATH      "wordle-trace.json"
+
+typedef struct {
+    uint64_t time;     // See monotonic_ns()
+    uint64_t session;  // The session's id (see start_session())
+    uint16_t event;
+    char phase;  // 'B' or 'E', as in the Chrome trace format
+} TraceRecord;
+
+// The latest TRACE_RING_SIZE events of one thread. Only that thread records
+// to it, so recording takes no lock or locked instruction, and a dump reads
+// it meanwhile.
+typedef struct TraceRing {
+    struct TraceRing* next;  // The ring of the thread that started before
+    int thread;
+    uint64_t head;  // Events ever recorded
+    TraceRecord records[TRACE_RING_SIZE];
+} TraceRing;
+
+// Every thread's ring, newest first. Rings are added but never removed.
+TraceRing* traceRings;
+int traceThreads;
+__thread TraceRing* threadRing;
+
+static const char* const eventNames[NUM_TRACE_EVENTS] = {
+        [TRACE_READ] = "read",
+        [TRACE_FEED] = "feed_session",
+        [TRACE_OPTION] = "process_option",
+        [TRACE_GUESS] = "judge_guess",
+        [TRACE_LOOKUP] = "find_word",
+        [TRACE_HINT] = "fill_hint",
+        [TRACE_SEND] = "send",
+};
+
+TraceRing* add_trace_ring(void);
+void* tracer_thread(void* arg);
+size_t copy_trace_ring(TraceRing* ring, TraceRecord* records);
+
+/* trace_event()
+ * −−−−−−−−−−−−−−−
+ * Records an event of the given phase in the calling thread's ring,
+ * overwriting its oldest event once the ring is full.
+ */
+void trace_event(TraceEvent event, char phase, uint64_t session) {
+    TraceRing* ring = threadRing;
+    if (!ring) {
+        ring = threadRing = add_trace_ring();
+    }
+    uint64_t head = ring->head;
+    TraceRecord* record = &ring->records[head & (TRACE_RING_SIZE - 1)];
+    record->time = monotonic_ns();
+    record->session = session;
+    record->event = event;
+    record->phase = phase;
+    // Publishes the record to dumps, which read head before the records.
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Gives the calling thread a ring, at its first event.
+TraceRing* add_trace_ring(void) {
+    TraceRing* ring = x_calloc(1, sizeof(TraceRing));
+    ring->thread = __atomic_add_fetch(&traceThreads, 1, __ATOMIC_RELAXED);
+    ring->next = __atomic_load_n(&traceRings, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&traceRings, &ring->next, ring, true,
+            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+    return ring;
+}
+
+/* start_tracer()
+ * −−−−−−−−−−−−−−−
+ * Blocks SIGUSR2 in the calling thread, and so in every thread it goes on
+ * to create, then starts a thread that writes every thread's recent events
+ * to TRACE_PATH each time the process receives it.
+ */
+void start_tracer(void) {
+    block_signals((int[]){SIGUSR2, 0});
+    pthread_t tid;
+    pthread_create(&tid, NULL, tracer_thread, NULL);
+    pthread_detach(tid);
+}
+
+void* tracer_thread(void* arg) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR2);
+    int sigNum;
+    while (true) {
+        sigwait(&set, &sigNum);
+        if (dump_traces(TRACE_PATH)) {
+            fprintf(stderr, "Wrote trace to %s\n", TRACE_PATH);
+        }
+    }
+    return NULL;
+}
+
+/* dump_traces()
+ * −−−−−−−−−−−−−−−
+ * Writes the events in every thread's ring to path in the Chrome trace
+ * format, which chrome://tracing and Perfetto open, without stopping the
+ * threads recording them. Each event carries its session's id.
+ *
+ * Returns: false if the file could not be written, otherwise true.
+ */
+bool dump_traces(char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    TraceRecord* records = x_malloc(sizeof(TraceRecord) * TRACE_RING_SIZE);
+    int pid = getpid();
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (TraceRing* ring = __atomic_load_n(&traceRings, __ATOMIC_ACQUIRE);
+            ring; ring = ring->next) {
+        size_t count = copy_trace_ring(ring, records);
+        for (size_t i = 0; i < count; i++) {
+            TraceRecord* record = &records[i];
+            fprintf(file,
+                    "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,"
+                    "\"pid\":%d,\"tid\":%d,\"args\":{\"session\":%lu}}",
+                    first ? "" : ",", eventNames[record->event],
+                    record->phase, record->time / 1000.0, pid,
+                    ring->thread, (unsigned long)record->session);
+            first = false;
+        }
+    }
+    fprintf(file, "\n]}\n");
+    free(records);
+    if (fclose(file)) {
+        perror(path);
+        return false;
+    }
+    return true;
+}
+
+/* copy_trace_ring()
+ * −−−−−−−−−−−−−−−
+ * Copies the events in a ring that may be being recorded to into records,
+ * oldest first, leaving out any its thread overwrote during the copy.
+ *
+ * Returns: the number of events copied.
+ */
+size_t copy_trace_ring(TraceRing* ring, TraceRecord* records) {
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    for (uint64_t i = tail; i < head; i++) {
+        records[i - tail] = ring->records[i & (TRACE_RING_SIZE - 1)];
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t after = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    // The thread may have overwritten events up to after - TRACE_RING_SIZE,
+    // and be overwriting the next, so events before overwritten are dropped.
+    uint64_t overwritten = after + 1 > TRACE_RING_SIZE
+            ? after + 1 - TRACE_RING_SIZE : 0;
+    if (overwritten <= tail) {
+        return head - tail;
+    }
+    if (overwritten >= head) {
+        return 0;
+    }
+    memmove(records, records + (overwritten - tail),
+            sizeof(TraceRecord) * (head - overwritten));
+    return head - overwritten;
+}
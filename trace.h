@@ -0,0 +1,35 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The spans traced on the server's hot paths, each recorded as a begin and
+// an end event.
+typedef enum {
+    TRACE_READ,    // Reading from a client's socket
+    TRACE_FEED,    // Handling everything one read brought in
+    TRACE_OPTION,  // Handling a menu option
+    TRACE_GUESS,   // Judging a guess
+    TRACE_LOOKUP,  // Finding a guess in the guesses list
+    TRACE_HINT,    // Working out a guess's hint
+    TRACE_SEND,    // Writing replies to a client's socket
+    NUM_TRACE_EVENTS,
+} TraceEvent;
+
+// Built with -DTRACE (make trace), every trace point records an event into
+// its thread's ring of recent events, which SIGUSR2 writes out. Otherwise
+// trace points compile to nothing.
+#ifdef TRACE
+#define TRACE_BEGIN(event, session) trace_event((event), 'B', (session))
+#define TRACE_END(event, session)   trace_event((event), 'E', (session))
+#else
+#define TRACE_BEGIN(event, session) ((void)0)
+#define TRACE_END(event, session)   ((void)0)
+#endif
+
+void trace_event(TraceEvent event, char phase, uint64_t session);
+void start_tracer(void);
+bool dump_traces(char* path);
+
+#endif  // TRACE_H
@@ -2,12 +2,24 @@
 
 #include <limits.h>
 #include <signal.h>
+#include <sys/resource.h>
+#include <time.h>
 
 #define INITIAL_BUFFER_SIZE 8
 
 #define EXIT_OUT_MEM 99
 
+// Built with -DCOUNT_ALLOCS (make allocs), every heap allocation made
+// through the x_ wrappers below is counted.
+#ifdef COUNT_ALLOCS
+size_t allocations;
+#define COUNT_ALLOC() __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED)
+#else
+#define COUNT_ALLOC()
+#endif
+
 char* x_strdup(char* str) {
+    COUNT_ALLOC();
     char* strDup = strdup(str);
     if (!strDup) {
         perror("strdup");
@@ -17,6 +29,7 @@ char* x_strdup(char* str) {
 }
 
 void* x_realloc(void* ptr, size_t size) {
+    COUNT_ALLOC();
     void* p = realloc(ptr, size);
     if (!p) {
         perror("realloc");
@@ -26,6 +39,7 @@ void* x_realloc(void* ptr, size_t size) {
 }
 
 void* x_calloc(size_t nmemb, size_t size) {
+    COUNT_ALLOC();
     void* ptr = calloc(nmemb, size);
     if (!ptr) {
         perror("calloc");
@@ -34,7 +48,19 @@ void* x_calloc(size_t nmemb, size_t size) {
     return ptr;
 }
 
+void* x_aligned_alloc(size_t alignment, size_t size) {
+    COUNT_ALLOC();
+    void* ptr;
+    int err = posix_memalign(&ptr, alignment, size);
+    if (err) {
+        fprintf(stderr, "posix_memalign: %s\n", strerror(err));
+        exit(EXIT_OUT_MEM);
+    }
+    return ptr;
+}
+
 void* x_malloc(size_t size) {
+    COUNT_ALLOC();
     void* ptr = malloc(size);
     if (!ptr) {
         perror("malloc");
@@ -43,6 +69,19 @@ void* x_malloc(size_t size) {
     return ptr;
 }
 
+/* allocation_count()
+ * −−−−−−−−−−−−−−−
+ * Returns: the number of allocations made so far, or 0 unless built to
+ * count them.
+ */
+size_t allocation_count(void) {
+#ifdef COUNT_ALLOCS
+    return __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+#else
+    return 0;
+#endif
+}
+
 /* parse_int()
  * −−−−−−−−−−−−−−−
  * Attempts to parse the src string as an integer and, if dest is not NULL,
@@ -125,21 +164,6 @@ char* read_line(FILE* file) {
     return buffer;
 }
 
-bool read_int(int* dest, FILE* to, FILE* from, char* msg, int min, int max) {
-    fprintf(to, "%s (%d to %d):\n", msg, min, max);
-    fflush(to);
-    char* input = read_line(from);
-    if (!input) {
-        return false;
-    }
-    if (parse_int(dest, input) && *dest >= min && *dest <= max) {
-        free(input);
-        return true;
-    }
-    free(input);
-    return read_int(dest, to, from, msg, min, max);
-}
-
 void ignore_signals(int sigNums[]) {
     struct sigaction sa;
     memset(&sa, 0, sizeof(sa));
@@ -148,3 +172,40 @@ void ignore_signals(int sigNums[]) {
         sigaction(sigNums[i], &sa, NULL);
     }
 }
+
+// Blocks the signals in this thread and any it goes on to create.
+void block_signals(int sigNums[]) {
+    sigset_t set;
+    sigemptyset(&set);
+    for (int i = 0; sigNums[i]; i++) {
+        sigaddset(&set, sigNums[i]);
+    }
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+}
+
+/* raise_fd_limit()
+ * −−−−−−−−−−−−−−−
+ * Lifts the soft limit on open files to the hard limit, as servers hold a
+ * socket for every client.
+ */
+void raise_fd_limit(void) {
+    struct rlimit limit;
+    if (!getrlimit(RLIMIT_NOFILE, &limit) && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+// Milliseconds on a clock that never jumps, for deadlines.
+uint64_t monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000ull + now.tv_nsec / 1000000;
+}
+
+// Nanoseconds on the same clock, for timing.
+uint64_t monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
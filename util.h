@@ -3,6 +3,7 @@
 
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,9 +12,14 @@ char* x_strdup(char* str);
 void* x_malloc(size_t size);
 void* x_realloc(void* ptr, size_t size);
 void* x_calloc(size_t nmemb, size_t size);
+void* x_aligned_alloc(size_t alignment, size_t size);
+size_t allocation_count(void);
 bool parse_int(int* dest, char* src);
 char* read_line(FILE* file);
-bool read_int(int* dest, FILE* to, FILE* from, char* msg, int min, int max);
 void ignore_signals(int sigNums[]);
+void block_signals(int sigNums[]);
+void raise_fd_limit(void);
+uint64_t monotonic_ms(void);
+uint64_t monotonic_ns(void);
 
 #endif  // UTIL_H
@@ -1,57 +1,448 @@
 #include "wordList.h"
 
-#define INITIAL_LIST_CAPACITY 72
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#define MIN_INDEX_SLOTS 16
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME        16777619u
+
+#define DICT_MAGIC      "WRDLDICT"
+#define DICT_MAGIC_LEN  8
+#define DICT_VERSION    1
+#define DICT_BYTE_ORDER 0x01020304u
+#define DICT_ALIGN      64
+
+/* Header of a compiled dictionary. It is followed (at the given file
+ * offsets) by the hash index, as uint32_t slots, and the word arena. Bucket
+ * offsets are relative to the start of the arena. All fields use the byte
+ * order of the machine that compiled the file.
+ */
+typedef struct {
+    char magic[DICT_MAGIC_LEN];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t maxWordLen;
+    uint32_t reserved;
+    uint64_t size;
+    uint64_t indexSlots;
+    uint64_t indexOffset;
+    uint64_t arenaOffset;
+    uint64_t arenaSize;
+    struct {
+        uint64_t start;
+        uint64_t count;
+        uint64_t offset;
+    } buckets[MAX_LIST_WORD_LEN + 1];
+} DictHeader;
+
+bool is_compiled(char* data, size_t dataLen);
+WordList* map_compiled(char* data, size_t dataLen);
+bool valid_contents(WordList* list);
+size_t arena_size(WordList* list);
+size_t hash_word(char* word, size_t len);
+int next_word(char** text, char* end, char** word);
+WordList* pack_words(char* text, size_t textLen);
+void build_index(WordList* list);
+uint32_t* find_slot(WordList* list, char* word, size_t len);
+
+/* init_word_list()
+ * −−−−−−−−−−−−−−−
+ * Loads the word list at path, which is either a dictionary compiled by
+ * save_word_list() or a newline separated text file.
+ *
+ * A compiled dictionary stays mapped read-only and is used in place, so
+ * loading it only takes one pass to check it, and server processes using
+ * the same file share its pages. A text file is mapped in one go and
+ * its valid words are packed into a single allocation holding the
+ * WordList, its hash index and the word arena.
+ *
+ * Returns: the word list, or NULL if the file could not be read or is an
+ * invalid compiled dictionary.
+ */
 WordList* init_word_list(char* path) {
-    FILE* file = fopen(path, "r");
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st)) {
+        perror("fstat");
+        close(fd);
+        return NULL;
+    }
+    char* data = NULL;
+    if (st.st_size > 0) {
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            perror("mmap");
+            close(fd);
+            return NULL;
+        }
+    }
+    close(fd);
+
+    if (is_compiled(data, st.st_size)) {
+        WordList* list = map_compiled(data, st.st_size);
+        if (!list) {
+            fprintf(stderr, "%s: invalid compiled dictionary\n", path);
+            munmap(data, st.st_size);
+        }
+        return list;
+    }
+    if (data) {
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+    }
+    WordList* list = pack_words(data, st.st_size);
+    if (data) {
+        munmap(data, st.st_size);
+    }
+    return list;
+}
+
+bool is_compiled(char* data, size_t dataLen) {
+    return dataLen >= DICT_MAGIC_LEN
+            && !memcmp(data, DICT_MAGIC, DICT_MAGIC_LEN);
+}
+
+/* map_compiled()
+ * −−−−−−−−−−−−−−−
+ * Wraps the mapped compiled dictionary in a WordList after checking that
+ * its header describes buckets and an index that fit inside the mapping,
+ * and that the words and index within them are safe to use.
+ *
+ * Returns: the word list, or NULL if the dictionary is invalid.
+ */
+WordList* map_compiled(char* data, size_t dataLen) {
+    DictHeader* header = (DictHeader*)data;
+    if (dataLen < sizeof(DictHeader) || header->version != DICT_VERSION
+            || header->byteOrder != DICT_BYTE_ORDER
+            || header->maxWordLen != MAX_LIST_WORD_LEN
+            || header->indexSlots < MIN_INDEX_SLOTS
+            || header->indexSlots & (header->indexSlots - 1)
+            || header->indexSlots <= header->size
+            || header->indexOffset % sizeof(uint32_t)
+            || header->indexOffset > dataLen
+            || header->indexSlots > (dataLen - header->indexOffset)
+                    / sizeof(uint32_t)
+            || header->arenaOffset > dataLen
+            || header->arenaSize > dataLen - header->arenaOffset) {
+        return NULL;
+    }
+
+    WordList* list = x_calloc(1, sizeof(WordList));
+    list->size = header->size;
+    list->index = (uint32_t*)(data + header->indexOffset);
+    list->indexMask = header->indexSlots - 1;
+    list->arena = data + header->arenaOffset;
+    list->mapping = data;
+    list->mappingSize = dataLen;
+
+    uint64_t start = 0;
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        uint64_t count = header->buckets[len].count;
+        uint64_t offset = header->buckets[len].offset;
+        if (header->buckets[len].start != start
+                || offset > header->arenaSize
+                || count > (header->arenaSize - offset) / (len + 1)) {
+            free(list);
+            return NULL;
+        }
+        list->buckets[len].start = start;
+        list->buckets[len].count = count;
+        list->buckets[len].words = list->arena + offset;
+        start += count;
+    }
+    if (start != header->size || !valid_contents(list)) {
+        free(list);
+        return NULL;
+    }
+    return list;
+}
+
+/* valid_contents()
+ * −−−−−−−−−−−−−−−
+ * Checks what a truncated or corrupt compiled dictionary could get wrong
+ * without breaking its header: that every word is NUL terminated, so no
+ * read runs past the arena, and that every index slot is empty or holds a
+ * word position, with at least one empty so probes always end.
+ *
+ * Returns: whether the list is safe to use.
+ */
+bool valid_contents(WordList* list) {
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        WordBucket* bucket = &list->buckets[len];
+        for (size_t i = 0; i < bucket->count; i++) {
+            if (bucket->words[i * (len + 1) + len]) {
+                return false;
+            }
+        }
+    }
+    bool empty = false;
+    for (size_t slot = 0; slot <= list->indexMask; slot++) {
+        if (list->index[slot] > list->size) {
+            return false;
+        }
+        empty |= !list->index[slot];
+    }
+    return empty;
+}
+
+/* save_word_list()
+ * −−−−−−−−−−−−−−−
+ * Writes the list to path as a compiled dictionary that init_word_list()
+ * can map directly. The file is written beside path and renamed into
+ * place, so servers never map a half written dictionary.
+ *
+ * Returns: true if the file was written, otherwise false.
+ */
+bool save_word_list(WordList* list, char* path) {
+    DictHeader header;
+    memset(&header, 0, sizeof(DictHeader));
+    memcpy(header.magic, DICT_MAGIC, DICT_MAGIC_LEN);
+    header.version = DICT_VERSION;
+    header.byteOrder = DICT_BYTE_ORDER;
+    header.maxWordLen = MAX_LIST_WORD_LEN;
+    header.size = list->size;
+    header.indexSlots = list->indexMask + 1;
+    header.indexOffset = (sizeof(DictHeader) + DICT_ALIGN - 1)
+            / DICT_ALIGN * DICT_ALIGN;
+    header.arenaOffset = header.indexOffset
+            + header.indexSlots * sizeof(uint32_t);
+    header.arenaSize = arena_size(list);
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        header.buckets[len].start = list->buckets[len].start;
+        header.buckets[len].count = list->buckets[len].count;
+        header.buckets[len].offset = list->buckets[len].words - list->arena;
+    }
+
+    char* tempPath = x_malloc(strlen(path) + sizeof(".tmp"));
+    sprintf(tempPath, "%s.tmp", path);
+    FILE* file = fopen(tempPath, "w");
     if (!file) {
         perror("fopen");
-        return NULL;
+        free(tempPath);
+        return false;
+    }
+    static const char padding[DICT_ALIGN];
+    bool ok = fwrite(&header, sizeof(DictHeader), 1, file) == 1
+            && fwrite(padding, header.indexOffset - sizeof(DictHeader), 1,
+                       file) <= 1
+            && fwrite(list->index, sizeof(uint32_t), header.indexSlots, file)
+                    == header.indexSlots
+            && fwrite(list->arena, 1, header.arenaSize, file)
+                    == header.arenaSize;
+    ok = !fclose(file) && ok;
+    if (!ok || rename(tempPath, path)) {
+        perror("save_word_list");
+        unlink(tempPath);
+        ok = false;
     }
-    WordList* list = x_malloc(sizeof(WordList));
-    list->size = 0;
-    list->capacity = INITIAL_LIST_CAPACITY;
-    list->words = x_malloc(sizeof(char*) * list->capacity);
+    free(tempPath);
+    return ok;
+}
 
+/* arena_size()
+ * −−−−−−−−−−−−−−−
+ * Returns: the number of bytes of the arena used by the list's words.
+ */
+size_t arena_size(WordList* list) {
+    size_t size = 0;
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        size_t end = list->buckets[len].words - list->arena
+                + list->buckets[len].count * (len + 1);
+        if (end > size) {
+            size = end;
+        }
+    }
+    return size;
+}
+
+/* hash_word()
+ * −−−−−−−−−−−−−−−
+ * 32-bit FNV-1a hash of the first len characters of word.
+ */
+size_t hash_word(char* word, size_t len) {
+    unsigned int hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)word[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/* next_word()
+ * −−−−−−−−−−−−−−−
+ * Scans the next line of the text between *text and end, advancing *text
+ * past it and pointing *word at its first character.
+ *
+ * Returns: the length of the line if it is a valid word (letters only, at
+ * most MAX_LIST_WORD_LEN long), 0 if it should be skipped, or -1 once the
+ * text is exhausted.
+ */
+int next_word(char** text, char* end, char** word) {
+    if (*text >= end) {
+        return -1;
+    }
+    char* line = *text;
+    char* newline = memchr(line, '\n', end - line);
+    char* lineEnd = newline ? newline : end;
+    *text = newline ? newline + 1 : end;
+    *word = line;
+
+    size_t len = lineEnd - line;
+    if (len > MAX_LIST_WORD_LEN) {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (!isalpha(line[i])) {
+            return 0;
+        }
+    }
+    return len;
+}
+
+/* pack_words()
+ * −−−−−−−−−−−−−−−
+ * Builds a WordList from the raw text in two passes: the first counts the
+ * words of each length to size the buckets, the second copies each word
+ * (lower cased) into the next fixed-stride slot of its bucket.
+ */
+WordList* pack_words(char* text, size_t textLen) {
+    char* end = text + textLen;
+    char* cursor = text;
     char* word;
-    while ((word = read_line(file))) {
-        if (!parse_word(word, -1, NULL)) {
-            free(word);
-            continue;
+    int len;
+    size_t counts[MAX_LIST_WORD_LEN + 1] = {0};
+    size_t size = 0, arenaSize = 0;
+    while ((len = next_word(&cursor, end, &word)) >= 0) {
+        if (len) {
+            counts[len]++;
+            size++;
+            arenaSize += len + 1;
         }
-        if (list->size == list->capacity - 1) {
-            list->capacity *= 2;
-            list->words = x_realloc(list->words,
-                    sizeof(char*) * list->capacity);
+    }
+
+    size_t slots = MIN_INDEX_SLOTS;
+    while (slots < size * 2) {
+        slots *= 2;
+    }
+    size_t indexSize = slots * sizeof(uint32_t);
+    WordList* list = x_calloc(1, sizeof(WordList) + indexSize + arenaSize);
+    list->size = size;
+    list->index = (uint32_t*)(list + 1);
+    list->indexMask = slots - 1;
+    list->arena = (char*)list->index + indexSize;
+
+    char* next[MAX_LIST_WORD_LEN + 1];
+    size_t start = 0;
+    char* words = list->arena;
+    for (len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        list->buckets[len].start = start;
+        list->buckets[len].count = counts[len];
+        list->buckets[len].words = next[len] = words;
+        start += counts[len];
+        words += counts[len] * (len + 1);
+    }
+
+    cursor = text;
+    while ((len = next_word(&cursor, end, &word)) >= 0) {
+        for (int i = 0; i < len; i++) {
+            next[len][i] = tolower(word[i]);
         }
-        list->words[list->size] = word;
-        list->size++;
+        next[len] += len + 1;
     }
-    fclose(file);
+    build_index(list);
     return list;
 }
 
-void free_word_list(WordList* list) {
-    if (!list) {
-        return;
+/* build_index()
+ * −−−−−−−−−−−−−−−
+ * Builds the read-only hash index used by in_list(). The table is kept at
+ * most half full so linear probing stays short. Each slot holds the
+ * position of a word in the list plus one, leaving zero to mark an empty
+ * slot.
+ */
+void build_index(WordList* list) {
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        WordBucket* bucket = &list->buckets[len];
+        for (size_t i = 0; i < bucket->count; i++) {
+            uint32_t* slot = find_slot(list, get_word(list, len, i), len);
+            // Duplicate words keep the slot of their first occurrence.
+            if (!*slot) {
+                *slot = bucket->start + i + 1;
+            }
+        }
     }
-    for (int i = 0; i < list->size; i++) {
-        free(list->words[i]);
+}
+
+/* find_slot()
+ * −−−−−−−−−−−−−−−
+ * Probes the hash index for word, which is len characters long.
+ *
+ * Returns: the slot holding word, or the empty slot where it would go.
+ */
+uint32_t* find_slot(WordList* list, char* word, size_t len) {
+    WordBucket* bucket = &list->buckets[len];
+    size_t slot = hash_word(word, len) & list->indexMask;
+    while (list->index[slot]) {
+        // Only words in the bucket for this length can be a match.
+        size_t i = list->index[slot] - 1 - bucket->start;
+        if (i < bucket->count
+                && !memcmp(word, bucket->words + i * (len + 1), len)) {
+            break;
+        }
+        slot = (slot + 1) & list->indexMask;
+    }
+    return &list->index[slot];
+}
+
+void free_word_list(WordList* list) {
+    if (list && list->mapping) {
+        munmap(list->mapping, list->mappingSize);
     }
-    free(list->words);
     free(list);
 }
 
 bool in_list(WordList* list, char* word) {
-    for (int i = 0; i < list->size; i++) {
-        if (!strcmp(word, list->words[i])) {
-            return true;
-        }
+    return find_word(list, word, NULL);
+}
+
+/* find_word()
+ * −−−−−−−−−−−−−−−
+ * Looks word up in the list and, if pos is not NULL, sets pos to its
+ * position among the words of the same length (see get_word()).
+ *
+ * Returns: true if the word is in the list, otherwise false.
+ */
+bool find_word(WordList* list, char* word, size_t* pos) {
+    size_t len = strlen(word);
+    if (len > MAX_LIST_WORD_LEN) {
+        return false;
+    }
+    uint32_t* slot = find_slot(list, word, len);
+    if (!*slot) {
+        return false;
+    }
+    if (pos) {
+        *pos = *slot - 1 - list->buckets[len].start;
     }
-    return false;
+    return true;
 }
 
-char* parse_word(char* word, int wordLen, FILE* stream) {
+/* parse_word()
+ * −−−−−−−−−−−−−−−
+ * Checks that word contains only letters and, unless wordLen is negative,
+ * is wordLen letters long, lower casing it in place and removing any
+ * newline.
+ *
+ * Returns: WORD_OK if the word is valid, otherwise the reason it is not.
+ */
+WordStatus parse_word(char* word, int wordLen) {
     int i;
     for (i = 0; word[i]; i++) {
         // Removing any trailing newline.
@@ -62,29 +453,53 @@ char* parse_word(char* word, int wordLen, FILE* stream) {
         }
 
         if (!isalpha(word[i])) {
-            if (stream) {
-                fprintf(stream,
-                        "Words must contain only letters - try again.\n");
-            }
-            return NULL;
+            return WORD_NOT_LETTERS;
         }
         word[i] = tolower(word[i]);
     }
     if (wordLen >= 0 && i != wordLen) {
-        if (stream) {
-            fprintf(stream, "Words must be %d letters long - try again.\n",
-                    wordLen);
-        }
+        return WORD_BAD_LENGTH;
+    }
+    return WORD_OK;
+}
+
+/* get_random_word()
+ * −−−−−−−−−−−−−−−
+ * Picks a random word of length wordLen from the list with a single
+ * unbiased draw from rng and, if pos is not NULL, sets pos to its position
+ * (see get_word()).
+ *
+ * Returns: the word, which belongs to the list, or NULL if the list has no
+ * words of that length.
+ */
+char* get_random_word(WordList* list, int wordLen, Rng* rng, size_t* pos) {
+    size_t count = count_words(list, wordLen);
+    if (!count) {
         return NULL;
     }
-    return word;
+    size_t i = random_below(rng, count);
+    if (pos) {
+        *pos = i;
+    }
+    return get_word(list, wordLen, i);
 }
 
-char* get_random_word(WordList* list, int wordLen) {
-    char* word;
-    do {
-        int i = rand() % list->size;
-        word = list->words[i];
-    } while (strlen(word) != wordLen);
-    return strdup(word);
+/* count_words()
+ * −−−−−−−−−−−−−−−
+ * Returns: the number of words of length wordLen in the list.
+ */
+size_t count_words(WordList* list, int wordLen) {
+    if (wordLen < 0 || wordLen > MAX_LIST_WORD_LEN) {
+        return 0;
+    }
+    return list->buckets[wordLen].count;
+}
+
+/* get_word()
+ * −−−−−−−−−−−−−−−
+ * Returns: the i'th word of length wordLen. i must be less than
+ * count_words(list, wordLen).
+ */
+char* get_word(WordList* list, int wordLen, size_t i) {
+    return list->buckets[wordLen].words + i * (wordLen + 1);
 }
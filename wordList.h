@@ -1,18 +1,43 @@
 #ifndef WORD_LIST_H
 #define WORD_LIST_H
 
+#include <stdint.h>
+
+#include "rng.h"
 #include "util.h"
 
+#define MAX_LIST_WORD_LEN 32  // Longer words are dropped when loading
+
+typedef struct {
+    size_t start;  // Position in the list of the first word of this length
+    size_t count;  // Number of words of this length
+    char* words;   // count NUL terminated words, each wordLen + 1 bytes
+} WordBucket;
+
 typedef struct {
-    char** words;
     size_t size;
-    size_t capacity;
+    uint32_t* index;    // Open addressing hash table of word positions + 1
+    size_t indexMask;   // Number of index slots - 1 (power of two)
+    WordBucket buckets[MAX_LIST_WORD_LEN + 1];
+    char* arena;        // Every word, packed bucket by bucket in file order
+    char* mapping;      // Compiled dictionary the list lives in, or NULL
+    size_t mappingSize;
 } WordList;
 
+typedef enum {
+    WORD_OK,
+    WORD_NOT_LETTERS,
+    WORD_BAD_LENGTH,
+} WordStatus;
+
 WordList* init_word_list(char* path);
+bool save_word_list(WordList* list, char* path);
 void free_word_list(WordList* list);
 bool in_list(WordList* list, char* word);
-char* parse_word(char* word, int wordLen, FILE* stream);
-char* get_random_word(WordList* list, int wordLen);
+bool find_word(WordList* list, char* word, size_t* pos);
+WordStatus parse_word(char* word, int wordLen);
+char* get_random_word(WordList* list, int wordLen, Rng* rng, size_t* pos);
+size_t count_words(WordList* list, int wordLen);
+char* get_word(WordList* list, int wordLen, size_t i);
 
 #endif  // WORD_LIST_H
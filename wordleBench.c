@@ -0,0 +1,542 @@
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "util.h"
+#include "wordList.h"
+
+#define EXIT_OK              0
+#define EXIT_BAD_USAGE       1
+#define EXIT_FNF             2
+#define EXIT_CONNECTION_FAIL 3
+
+#define DEFAULT_WORDS_PATH  "default-answers.txt"
+#define SERVER_PATH         "./wordle-server"
+#define DEFAULT_CONNECTIONS 100
+#define DEFAULT_THREADS     1
+#define DEFAULT_GAMES       1
+#define DEFAULT_SECONDS     5
+#define MAX_CONNECTIONS     1000000
+#define MAX_THREADS         1024
+
+#define WORD_LEN    5  // The server's default word length
+#define MAX_EVENTS  256
+#define REPLY_LEN   4096
+#define INITIAL_LATENCIES 4096
+
+#define CMD_OPTION '-'
+
+// Ends of the replies the bench waits for before sending its next line.
+#define PROMPT_END "):\n"
+#define MENU_EXIT  "5. Exit\n"  // Followed only by the log in option, if any
+
+// Where a connection is in its games. Each state waits for one reply.
+typedef enum {
+    BENCH_CONNECTING,  // For connect() to finish
+    BENCH_MENU,        // For the welcome and menu
+    BENCH_STARTING,    // For the first prompt of a game
+    BENCH_GUESSING,    // For the hint and the next prompt or the menu
+    BENCH_CLOSING,     // For the server to close after "Goodbye"
+} BenchState;
+
+typedef struct {
+    int fd;
+    BenchState state;
+    int gamesLeft;
+    double sentAt;  // When the last guess was sent
+    size_t replyLen;
+    char reply[REPLY_LEN];
+} BenchConn;
+
+typedef struct {
+    WordList* words;
+    struct addrinfo* server;
+    int numConns;
+    int gamesPerConn;
+    double endAt;
+    unsigned int seed;
+    int epollFd;
+    // Results
+    long connections;
+    long games;
+    long failures;
+    double* latencies;  // Seconds from each guess to its reply
+    size_t numLatencies;
+    size_t latencyCapacity;
+} BenchThread;
+
+double now(void);
+void usage_exit(void);
+pid_t spawn_server(char** serverArgs, char* wordsPath, char** port);
+void* bench_thread(void* rawThread);
+bool open_conn(BenchThread* thread, BenchConn* conn);
+bool serve_conn(BenchThread* thread, BenchConn* conn);
+bool read_reply(BenchConn* conn, bool* closed);
+bool reply_ends_with(BenchConn* conn, char* end);
+bool reply_ends_menu(BenchConn* conn);
+bool send_line(BenchConn* conn, char* line);
+void add_latency(BenchThread* thread, double latency);
+int compare_doubles(const void* a, const void* b);
+bool report(BenchThread* threads, int numThreads, double elapsed);
+
+/* Wordle Benchmark
+ * −−−−−−−−−−−−−−−
+ * Usage: ./wordle-bench [-connections n] [-threads n] [-games n]
+ *                       [-seconds n] [-words file]
+ *                       [hostname port | -- server arguments]
+ *
+ * Drives full games over the text protocol from many concurrent
+ * connections, each playing -games games before exiting and reconnecting,
+ * and reports connections, games and guesses per second with percentiles
+ * of the time from each guess to its reply. Guesses are random WORD_LEN
+ * letter words from -words. Without a hostname and port it starts its own
+ * wordle-server on an ephemeral port, passing it any arguments after --.
+ * Exits with EXIT_CONNECTION_FAIL if any connection failed.
+ */
+int main(int argc, char** argv) {
+    int numConns = DEFAULT_CONNECTIONS, numThreads = DEFAULT_THREADS;
+    int games = DEFAULT_GAMES, seconds = DEFAULT_SECONDS;
+    char* wordsPath = DEFAULT_WORDS_PATH;
+    char* hostname = NULL;
+    char* port = NULL;
+    char** serverArgs = NULL;
+
+    int i;
+    for (i = 1; argv[i] && strcmp(argv[i], "--"); i++) {
+        int* dest = NULL;
+        int max = MAX_CONNECTIONS;
+        if (argv[i][0] != CMD_OPTION) {
+            if (port || !argv[i + 1] || argv[i + 1][0] == CMD_OPTION) {
+                usage_exit();
+            }
+            hostname = argv[i++];
+            port = argv[i];
+            continue;
+        }
+        if (!argv[i + 1]) {
+            usage_exit();
+        } else if (!strcmp(argv[i], "-words")) {
+            wordsPath = argv[++i];
+            continue;
+        } else if (!strcmp(argv[i], "-connections")) {
+            dest = &numConns;
+        } else if (!strcmp(argv[i], "-threads")) {
+            dest = &numThreads;
+            max = MAX_THREADS;
+        } else if (!strcmp(argv[i], "-games")) {
+            dest = &games;
+        } else if (!strcmp(argv[i], "-seconds")) {
+            dest = &seconds;
+        } else {
+            usage_exit();
+        }
+        if (!parse_int(dest, argv[++i]) || *dest < 1 || *dest > max) {
+            usage_exit();
+        }
+    }
+    if (argv[i]) {
+        if (port) {
+            usage_exit();
+        }
+        serverArgs = &argv[i + 1];
+    }
+    if (numThreads > numConns) {
+        numThreads = numConns;
+    }
+
+    WordList* words = init_word_list(wordsPath);
+    if (!words) {
+        return EXIT_FNF;
+    }
+    if (!count_words(words, WORD_LEN)) {
+        fprintf(stderr, "wordle-bench: no %d letter words in %s\n", WORD_LEN,
+                wordsPath);
+        return EXIT_FNF;
+    }
+    ignore_signals((int[]){SIGPIPE, 0});
+    raise_fd_limit();
+
+    pid_t server = -1;
+    if (!port) {
+        server = spawn_server(serverArgs, wordsPath, &port);
+        hostname = "localhost";
+    }
+    struct addrinfo* info = NULL;
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(struct addrinfo));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (!port || getaddrinfo(hostname, port, &hints, &info)) {
+        fprintf(stderr, "wordle-bench: unable to find the server\n");
+        if (server > 0) {
+            kill(server, SIGTERM);
+        }
+        return EXIT_CONNECTION_FAIL;
+    }
+
+    BenchThread* threads = x_calloc(numThreads, sizeof(BenchThread));
+    pthread_t* tids = x_malloc(sizeof(pthread_t) * numThreads);
+    double start = now();
+    for (int t = 0; t < numThreads; t++) {
+        threads[t].words = words;
+        threads[t].server = info;
+        threads[t].numConns = numConns / numThreads
+                + (t < numConns % numThreads);
+        threads[t].gamesPerConn = games;
+        threads[t].endAt = start + seconds;
+        threads[t].seed = time(NULL) + t;
+        pthread_create(&tids[t], NULL, bench_thread, &threads[t]);
+    }
+    for (int t = 0; t < numThreads; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    bool ok = report(threads, numThreads, now() - start);
+
+    for (int t = 0; t < numThreads; t++) {
+        free(threads[t].latencies);
+    }
+    free(threads);
+    free(tids);
+    freeaddrinfo(info);
+    free_word_list(words);
+    if (server > 0) {
+        kill(server, SIGTERM);
+        waitpid(server, NULL, 0);
+        free(port);
+    }
+    return ok ? EXIT_OK : EXIT_CONNECTION_FAIL;
+}
+
+double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* spawn_server()
+ * −−−−−−−−−−−−−−−
+ * Starts SERVER_PATH on an ephemeral port with wordsPath as its answers
+ * and guesses followed by serverArgs, and reads the port it is listening
+ * on from its first line of stderr into a newly allocated *port.
+ *
+ * Returns: the server's pid, or -1 if it could not be started, in which
+ * case *port is NULL.
+ */
+pid_t spawn_server(char** serverArgs, char* wordsPath, char** port) {
+    *port = NULL;
+    int numArgs = 0;
+    while (serverArgs && serverArgs[numArgs]) {
+        numArgs++;
+    }
+    char** args = x_malloc(sizeof(char*) * (numArgs + 6));
+    args[0] = SERVER_PATH;
+    args[1] = "-answers";
+    args[2] = wordsPath;
+    args[3] = "-guesses";
+    args[4] = wordsPath;
+    for (int i = 0; i < numArgs; i++) {
+        args[i + 5] = serverArgs[i];
+    }
+    args[numArgs + 5] = NULL;
+
+    int fds[2];
+    if (pipe(fds)) {
+        perror("pipe");
+        free(args);
+        return -1;
+    }
+    pid_t pid = fork();
+    if (!pid) {
+        dup2(fds[1], STDERR_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execv(SERVER_PATH, args);
+        perror(SERVER_PATH);
+        _exit(EXIT_FNF);
+    }
+    free(args);
+    close(fds[1]);
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        return -1;
+    }
+
+    // The pipe stays open so the server can keep writing to it.
+    FILE* from = fdopen(fds[0], "r");
+    char* line = read_line(from);
+    char* last = line ? strrchr(line, ' ') : NULL;
+    if (last) {
+        *port = x_strdup(last + 1);
+    } else {
+        fprintf(stderr, "wordle-bench: %s did not start\n", SERVER_PATH);
+    }
+    free(line);
+    return pid;
+}
+
+void* bench_thread(void* rawThread) {
+    BenchThread* thread = rawThread;
+    thread->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    BenchConn* conns = x_calloc(thread->numConns, sizeof(BenchConn));
+    for (int i = 0; i < thread->numConns; i++) {
+        if (!open_conn(thread, &conns[i])) {
+            thread->failures++;
+        }
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (now() < thread->endAt) {
+        int numEvents = epoll_wait(thread->epollFd, events, MAX_EVENTS,
+                (thread->endAt - now()) * 1000 + 1);
+        for (int i = 0; i < numEvents; i++) {
+            BenchConn* conn = events[i].data.ptr;
+            if (!serve_conn(thread, conn)) {
+                thread->failures++;
+                close(conn->fd);
+                if (!open_conn(thread, conn)) {
+                    thread->failures++;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < thread->numConns; i++) {
+        if (conns[i].fd >= 0) {
+            close(conns[i].fd);
+        }
+    }
+    close(thread->epollFd);
+    free(conns);
+    return NULL;
+}
+
+/* open_conn()
+ * −−−−−−−−−−−−−−−
+ * Starts a non-blocking connection to the server and watches it with
+ * epoll.
+ *
+ * Returns: false if the connection could not be started, otherwise true.
+ */
+bool open_conn(BenchThread* thread, BenchConn* conn) {
+    memset(conn, 0, sizeof(BenchConn));
+    conn->state = BENCH_CONNECTING;
+    conn->gamesLeft = thread->gamesPerConn;
+    conn->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (conn->fd < 0) {
+        return false;
+    }
+    if (connect(conn->fd, thread->server->ai_addr, thread->server->ai_addrlen)
+            && errno != EINPROGRESS) {
+        close(conn->fd);
+        conn->fd = -1;
+        return false;
+    }
+    struct epoll_event event = {.events = EPOLLIN | EPOLLOUT,
+            .data.ptr = conn};
+    if (epoll_ctl(thread->epollFd, EPOLL_CTL_ADD, conn->fd, &event)) {
+        close(conn->fd);
+        conn->fd = -1;
+        return false;
+    }
+    return true;
+}
+
+/* serve_conn()
+ * −−−−−−−−−−−−−−−
+ * Moves a connection on once the reply it is waiting for has arrived in
+ * full: starting a game from the menu, guessing until the game is over,
+ * and exiting and reconnecting after its last game.
+ *
+ * Returns: false if the connection failed, otherwise true.
+ */
+bool serve_conn(BenchThread* thread, BenchConn* conn) {
+    if (conn->state == BENCH_CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(int);
+        if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &err, &len) || err) {
+            return false;
+        }
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = conn};
+        conn->state = BENCH_MENU;
+        return !epoll_ctl(thread->epollFd, EPOLL_CTL_MOD, conn->fd, &event);
+    }
+
+    bool closed;
+    if (!read_reply(conn, &closed)) {
+        return false;
+    }
+    if (closed) {
+        if (conn->state != BENCH_CLOSING) {
+            return false;
+        }
+        thread->connections++;
+        close(conn->fd);
+        return open_conn(thread, conn);
+    }
+
+    if (conn->state == BENCH_CLOSING) {
+        return true;  // Nothing to do until the server closes
+    }
+    bool prompted = reply_ends_with(conn, PROMPT_END);
+    bool menu = reply_ends_menu(conn);
+    if (conn->state == BENCH_STARTING && menu) {
+        return false;  // The server has no answers to play
+    }
+    if (!(conn->state == BENCH_MENU ? menu
+                : conn->state == BENCH_STARTING ? prompted
+                                                : prompted || menu)) {
+        return true;  // The rest of the reply is still to come
+    }
+
+    // A guess that ends with the menu rather than a prompt ended the game.
+    bool gameOver = conn->state == BENCH_GUESSING && menu;
+    if (conn->state == BENCH_GUESSING) {
+        add_latency(thread, now() - conn->sentAt);
+    }
+    conn->replyLen = 0;
+    if (gameOver) {
+        thread->games++;
+        conn->gamesLeft--;
+    }
+    if (conn->state == BENCH_MENU || gameOver) {
+        if (!conn->gamesLeft) {
+            conn->state = BENCH_CLOSING;
+            return send_line(conn, "5\n");
+        }
+        conn->state = BENCH_STARTING;
+        return send_line(conn, "1\n");
+    }
+
+    char guess[WORD_LEN + 2];
+    size_t count = count_words(thread->words, WORD_LEN);
+    strcpy(guess, get_word(thread->words, WORD_LEN,
+                    rand_r(&thread->seed) % count));
+    strcat(guess, "\n");
+    conn->state = BENCH_GUESSING;
+    conn->sentAt = now();
+    return send_line(conn, guess);
+}
+
+/* read_reply()
+ * −−−−−−−−−−−−−−−
+ * Appends what the server has sent to conn->reply, NUL terminated and
+ * keeping only the end of replies too long to fit, and sets closed if the
+ * server has closed the connection.
+ *
+ * Returns: false if the connection failed, otherwise true.
+ */
+bool read_reply(BenchConn* conn, bool* closed) {
+    char chunk[REPLY_LEN];
+    ssize_t size = read(conn->fd, chunk, REPLY_LEN);
+    *closed = !size;
+    if (size < 0) {
+        return errno == EAGAIN || errno == EINTR;
+    }
+    if (conn->replyLen + size >= REPLY_LEN) {
+        conn->replyLen = 0;
+        if ((size_t)size >= REPLY_LEN / 2) {
+            memmove(chunk, chunk + size - REPLY_LEN / 2, REPLY_LEN / 2);
+            size = REPLY_LEN / 2;
+        }
+    }
+    memcpy(conn->reply + conn->replyLen, chunk, size);
+    conn->replyLen += size;
+    conn->reply[conn->replyLen] = 0;
+    return true;
+}
+
+bool reply_ends_with(BenchConn* conn, char* end) {
+    size_t len = strlen(end);
+    return conn->replyLen >= len
+            && !strcmp(conn->reply + conn->replyLen - len, end);
+}
+
+/* reply_ends_menu()
+ * −−−−−−−−−−−−−−−
+ * Returns: whether the reply so far ends with the whole menu, which is
+ * "5. Exit" and, when the server keeps player profiles, one more line for
+ * logging in.
+ */
+bool reply_ends_menu(BenchConn* conn) {
+    char* exit = strstr(conn->reply, MENU_EXIT);
+    if (!exit) {
+        return false;
+    }
+    char* rest = exit + strlen(MENU_EXIT);
+    return !rest[0] || (!strncmp(rest, "6. ", 3)
+            && strchr(rest, '\n') == conn->reply + conn->replyLen - 1);
+}
+
+bool send_line(BenchConn* conn, char* line) {
+    size_t len = strlen(line);
+    return send(conn->fd, line, len, MSG_NOSIGNAL) == (ssize_t)len;
+}
+
+void add_latency(BenchThread* thread, double latency) {
+    if (thread->numLatencies == thread->latencyCapacity) {
+        thread->latencyCapacity = thread->latencyCapacity
+                ? thread->latencyCapacity * 2 : INITIAL_LATENCIES;
+        thread->latencies = x_realloc(thread->latencies,
+                sizeof(double) * thread->latencyCapacity);
+    }
+    thread->latencies[thread->numLatencies++] = latency;
+}
+
+int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* report()
+ * −−−−−−−−−−−−−−−
+ * Prints the rates and guess latency percentiles over every thread.
+ *
+ * Returns: false if any connection failed or no game finished, so scripts
+ * can tell a broken server from a slow one.
+ */
+bool report(BenchThread* threads, int numThreads, double elapsed) {
+    long connections = 0, games = 0, failures = 0;
+    size_t numLatencies = 0;
+    for (int t = 0; t < numThreads; t++) {
+        connections += threads[t].connections;
+        games += threads[t].games;
+        failures += threads[t].failures;
+        numLatencies += threads[t].numLatencies;
+    }
+    double* latencies = x_malloc(sizeof(double) * (numLatencies + 1));
+    size_t filled = 0;
+    for (int t = 0; t < numThreads; t++) {
+        memcpy(latencies + filled, threads[t].latencies,
+                sizeof(double) * threads[t].numLatencies);
+        filled += threads[t].numLatencies;
+    }
+    qsort(latencies, numLatencies, sizeof(double), compare_doubles);
+    latencies[numLatencies] = 0;  // So empty runs report zeroes
+
+    printf("seconds        %10.2f\n", elapsed);
+    printf("connections/s  %10.0f\n", connections / elapsed);
+    printf("games/s        %10.0f\n", games / elapsed);
+    printf("guesses/s      %10.0f\n", numLatencies / elapsed);
+    printf("failures       %10ld\n", failures);
+    printf("guess p50 us   %10.1f\n",
+            latencies[numLatencies / 2] * 1e6);
+    printf("guess p99 us   %10.1f\n",
+            latencies[(size_t)(numLatencies * 0.99)] * 1e6);
+    printf("guess p999 us  %10.1f\n",
+            latencies[(size_t)(numLatencies * 0.999)] * 1e6);
+    free(latencies);
+    return !failures && games;
+}
+
+void usage_exit(void) {
+    fprintf(stderr, "Usage: wordle-bench [-connections n] [-threads n] "
+                    "[-games n] [-seconds n] [-words file] "
+                    "[hostname port | -- server arguments]\n");
+    exit(EXIT_BAD_USAGE);
+}
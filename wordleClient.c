@@ -5,6 +5,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "hint.h"
+#include "protocol.h"
 #include "util.h"
 
 #define EXIT_OK              0
@@ -13,6 +15,8 @@
 
 #define NUM_ARGS 3
 
+#define READ_CHUNK 4096
+
 typedef struct Comms {
     FILE* input;
     FILE* output;
@@ -23,23 +27,41 @@ int connect_to_server(char* hostname, char* port);
 void communicate_with_server(int sockFd);
 void* communicate_thread(void* args);
 Comms* init_comms(FILE* input, FILE* output, bool fromServer);
+void play_binary(int sockFd);
+bool parse_command(char* line, Frame* request);
+void send_probes(int sockFd, char* words);
+void print_reply(Frame* request, Frame* reply);
+bool write_frame(int sockFd, Frame* frame);
+bool read_frame(int sockFd, Frame* frame);
+bool read_hello(int sockFd, Frame* frame);
 
+/* Wordle Client
+ * −−−−−−−−−−−−−−−
+ * Usage: ./wordle-client [-binary] hostname port
+ *
+ * Passes lines between stdin and the server's text protocol, or with
+ * -binary speaks the binary protocol and translates commands from stdin.
+ */
 int main(int argc, char** argv) {
-    if (argc != NUM_ARGS) {
-        fprintf(stderr, "Usage: wordle-client hostname port\n");
+    bool binary = argc == NUM_ARGS + 1 && !strcmp(argv[1], "-binary");
+    if (argc != NUM_ARGS + binary) {
+        fprintf(stderr, "Usage: wordle-client [-binary] hostname port\n");
         return EXIT_BAD_USAGE;
     }
 
     ignore_signals((int[]){SIGPIPE, 0});
 
-    char* hostname = argv[1];
-    char* port = argv[2];
+    char* hostname = argv[1 + binary];
+    char* port = argv[2 + binary];
     int sockFd = connect_to_server(hostname, port);
     if (sockFd < 0) {
         fprintf(stderr, "wordle-client: unable to connect to %s port %s\n",
                 hostname, port);
         return EXIT_CONNECTION_FAIL;
     }
+    if (binary) {
+        play_binary(sockFd);
+    }
     communicate_with_server(sockFd);
     return EXIT_OK;  // Will never reach here
 }
@@ -84,6 +106,251 @@ void* communicate_thread(void* comms) {
     return NULL;  // Never reach here
 }
 
+/* play_binary()
+ * −−−−−−−−−−−−−−−
+ * Switches the connection to the binary protocol, then sends a request for
+ * each command read from stdin and prints the server's reply. Exits when
+ * either side is done.
+ */
+void play_binary(int sockFd) {
+    Frame request, reply;
+    memset(&request, 0, sizeof(Frame));
+    request.code = OP_HELLO;
+    if (!write_frame(sockFd, &request) || !read_hello(sockFd, &reply)) {
+        fprintf(stderr, "wordle-client: server does not speak binary\n");
+        exit(EXIT_CONNECTION_FAIL);
+    }
+    printf("Commands: play, length n, tries n, cheat [word], "
+           "probe word..., candidates, login name, exit\n"
+           "Anything else is a guess.\n");
+    fflush(stdout);
+
+    char* line;
+    while ((line = read_line(stdin))) {
+        if (!strncmp(line, "probe ", strlen("probe "))) {
+            send_probes(sockFd, line + strlen("probe "));
+        } else if (parse_command(line, &request)) {
+            if (!write_frame(sockFd, &request)
+                    || !read_frame(sockFd, &reply)) {
+                printf("Server closed the connection\n");
+                exit(EXIT_CONNECTION_FAIL);
+            }
+            print_reply(&request, &reply);
+            if (reply.code == STATUS_BYE || reply.code == STATUS_TIMED_OUT) {
+                exit(EXIT_OK);
+            }
+        }
+        free(line);
+    }
+    exit(EXIT_OK);
+}
+
+/* parse_command()
+ * −−−−−−−−−−−−−−−
+ * Turns a command from the user into a request, printing why when it
+ * cannot.
+ *
+ * Returns: true if the request should be sent, otherwise false.
+ */
+bool parse_command(char* line, Frame* request) {
+    memset(request, 0, sizeof(Frame));
+    char* arg = strchr(line, ' ');
+    if (arg) {
+        *arg++ = 0;
+    }
+    int value = 0;
+    if (!strcmp(line, "play")) {
+        request->code = OP_PLAY;
+    } else if (!strcmp(line, "exit")) {
+        request->code = OP_EXIT;
+    } else if (!strcmp(line, "candidates")) {
+        request->code = OP_CANDIDATES;
+    } else if (!strcmp(line, "login")) {
+        if (!arg || !arg[0] || strlen(arg) > FRAME_WORD_LEN) {
+            printf("Usage: login name (at most %d characters)\n",
+                    FRAME_WORD_LEN);
+            return false;
+        }
+        request->code = OP_LOGIN;
+        strcpy(request->word, arg);
+    } else if (!strcmp(line, "length") || !strcmp(line, "tries")) {
+        if (!parse_int(&value, arg) || value < 0 || value > UINT8_MAX) {
+            printf("Usage: %s n\n", line);
+            return false;
+        }
+        request->code = line[0] == 'l' ? OP_WORD_LEN : OP_TRIES;
+        request->arg = value;
+    } else {
+        bool cheat = !strcmp(line, "cheat");
+        char* word = cheat ? (arg ? arg : "") : line;
+        if (strlen(word) > FRAME_WORD_LEN || (!cheat && arg)) {
+            printf("Words are at most %d letters long\n", FRAME_WORD_LEN);
+            return false;
+        }
+        request->code = cheat ? OP_CHEAT : OP_GUESS;
+        for (int i = 0; word[i]; i++) {
+            request->word[i] = tolower(word[i]);
+        }
+    }
+    return true;
+}
+
+/* send_probes()
+ * −−−−−−−−−−−−−−−
+ * Sends an OP_PROBE for each space separated word in a single write, then
+ * prints the hint for each as the replies arrive.
+ */
+void send_probes(int sockFd, char* words) {
+    Frame* requests = NULL;
+    char* bytes = NULL;
+    int numWords = 0;
+    char* save;
+    for (char* word = strtok_r(words, " ", &save); word;
+            word = strtok_r(NULL, " ", &save), numWords++) {
+        requests = x_realloc(requests, sizeof(Frame) * (numWords + 1));
+        bytes = x_realloc(bytes, FRAME_LEN * (numWords + 1));
+        memset(&requests[numWords], 0, sizeof(Frame));
+        requests[numWords].code = OP_PROBE;
+        for (int i = 0; word[i] && i < FRAME_WORD_LEN; i++) {
+            requests[numWords].word[i] = tolower(word[i]);
+        }
+        encode_frame(&requests[numWords], bytes + FRAME_LEN * numWords);
+    }
+
+    Frame reply;
+    bool ok = send(sockFd, bytes, FRAME_LEN * numWords, MSG_NOSIGNAL)
+            == FRAME_LEN * numWords;
+    for (int i = 0; ok && i < numWords; i++) {
+        if ((ok = read_frame(sockFd, &reply))) {
+            printf("%s ", requests[i].word);
+            print_reply(&requests[i], &reply);
+        }
+    }
+    free(requests);
+    free(bytes);
+    if (!ok) {
+        printf("Server closed the connection\n");
+        exit(EXIT_CONNECTION_FAIL);
+    }
+}
+
+void print_reply(Frame* request, Frame* reply) {
+    char hint[FRAME_WORD_LEN + 1];
+    render_hint(reply->pattern, request->word, strlen(request->word), hint);
+    switch (reply->code) {
+        case STATUS_OK:
+            if (request->code == OP_TRIES) {
+                printf("Tries: %d\n", reply->arg);
+            } else {
+                printf("Word length: %d\n", reply->arg);
+            }
+            break;
+        case STATUS_STARTED:
+            printf("Guess the %d letter word in %d tries\n", reply->arg,
+                    reply->triesLeft);
+            break;
+        case STATUS_HINT:
+            if (request->code == OP_PROBE) {
+                printf("%s\n", hint);
+            } else {
+                printf("%s (%d tries left)\n", hint, reply->triesLeft);
+            }
+            break;
+        case STATUS_WON:
+            printf("%s Correct! Win streak: %d\n", hint, reply->streak);
+            break;
+        case STATUS_LOST:
+            printf("%s Bad luck - the word is \"%s\". Win streak: %d\n",
+                    hint, reply->word, reply->streak);
+            break;
+        case STATUS_NOT_LETTERS:
+            printf("Words must contain only letters\n");
+            break;
+        case STATUS_BAD_LENGTH:
+            printf("Wrong word length\n");
+            break;
+        case STATUS_NOT_WORD:
+            printf("Word not found in the dictionary\n");
+            break;
+        case STATUS_NO_ANSWERS:
+            printf("No %d letter answers are available\n", reply->arg);
+            break;
+        case STATUS_BAD_VALUE:
+            printf("Out of range\n");
+            break;
+        case STATUS_BYE:
+            printf("Goodbye...\n");
+            break;
+        case STATUS_LOGGED_IN:
+            printf("Playing as %s: %d games played. Win streak: %d\n",
+                    request->word, reply->arg, reply->streak);
+            break;
+        case STATUS_CANDIDATES:
+            printf("%s candidates left\n", reply->word);
+            break;
+        case STATUS_TIMED_OUT:
+            if (reply->word[0]) {
+                printf("Out of time - the word was \"%s\"\n", reply->word);
+            } else {
+                printf("Timed out\n");
+            }
+            break;
+        default:
+            printf("Not allowed now\n");
+    }
+    fflush(stdout);
+}
+
+bool write_frame(int sockFd, Frame* frame) {
+    char bytes[FRAME_LEN];
+    encode_frame(frame, bytes);
+    return send(sockFd, bytes, FRAME_LEN, MSG_NOSIGNAL) == FRAME_LEN;
+}
+
+bool read_frame(int sockFd, Frame* frame) {
+    char bytes[FRAME_LEN];
+    for (size_t have = 0; have < FRAME_LEN;) {
+        ssize_t size = read(sockFd, bytes + have, FRAME_LEN - have);
+        if (size <= 0) {
+            return false;
+        }
+        have += size;
+    }
+    decode_frame(bytes, frame);
+    return true;
+}
+
+/* read_hello()
+ * −−−−−−−−−−−−−−−
+ * Reads the server's reply to OP_HELLO, skipping the welcome text sent
+ * before it up to the NUL status byte that starts the frame.
+ *
+ * Returns: true if the server switched to the binary protocol.
+ */
+bool read_hello(int sockFd, Frame* frame) {
+    char chunk[READ_CHUNK];
+    char bytes[FRAME_LEN];
+    size_t have = 0;
+    while (have < FRAME_LEN) {
+        ssize_t size = read(sockFd, chunk, READ_CHUNK);
+        if (size <= 0) {
+            return false;
+        }
+        char* start = chunk;
+        if (!have && !(start = memchr(chunk, STATUS_HELLO, size))) {
+            continue;
+        }
+        size_t take = chunk + size - start;
+        if (take > FRAME_LEN - have) {
+            take = FRAME_LEN - have;
+        }
+        memcpy(bytes + have, start, take);
+        have += take;
+    }
+    decode_frame(bytes, frame);
+    return frame->code == STATUS_HELLO && frame->arg == PROTOCOL_VERSION;
+}
+
 int connect_to_server(char* hostname, char* port) {
     struct addrinfo* info = NULL;
     struct addrinfo hints;
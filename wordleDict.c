@@ -0,0 +1,63 @@
+#include "util.h"
+#include "wordList.h"
+
+#define EXIT_OK         0
+#define EXIT_BAD_USAGE  1
+#define EXIT_FNF        2
+#define EXIT_WRITE_FAIL 3
+
+void usage_exit(void);
+int compile_dict(char* input, char* output);
+int print_info(char* path);
+
+/* Wordle Dictionary Tool
+ * −−−−−−−−−−−−−−−
+ * Usage: ./wordle-dict compile input output
+ *        ./wordle-dict info file
+ *
+ * compile turns a newline separated word list into a compiled dictionary
+ * that wordle-server maps directly with -answers or -guesses.
+ * info prints the number of words of each length in any word list.
+ */
+int main(int argc, char** argv) {
+    if (argc == 4 && !strcmp(argv[1], "compile")) {
+        return compile_dict(argv[2], argv[3]);
+    }
+    if (argc == 3 && !strcmp(argv[1], "info")) {
+        return print_info(argv[2]);
+    }
+    usage_exit();
+    return EXIT_BAD_USAGE;  // Never reach here
+}
+
+int compile_dict(char* input, char* output) {
+    WordList* list = init_word_list(input);
+    if (!list) {
+        return EXIT_FNF;
+    }
+    bool ok = save_word_list(list, output);
+    free_word_list(list);
+    return ok ? EXIT_OK : EXIT_WRITE_FAIL;
+}
+
+int print_info(char* path) {
+    WordList* list = init_word_list(path);
+    if (!list) {
+        return EXIT_FNF;
+    }
+    printf("%s: %s, %zu words\n", path,
+            list->mapping ? "compiled" : "text", list->size);
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        if (count_words(list, len)) {
+            printf("%2d letters: %zu\n", len, count_words(list, len));
+        }
+    }
+    free_word_list(list);
+    return EXIT_OK;
+}
+
+void usage_exit(void) {
+    fprintf(stderr, "Usage: wordle-dict compile input output\n"
+                    "       wordle-dict info file\n");
+    exit(EXIT_BAD_USAGE);
+}
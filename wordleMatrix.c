@@ -0,0 +1,88 @@
+#include <time.h>
+#include <unistd.h>
+
+#include "feedbackMatrix.h"
+#include "util.h"
+#include "wordList.h"
+
+#define EXIT_OK         0
+#define EXIT_BAD_USAGE  1
+#define EXIT_FNF        2
+#define EXIT_WRITE_FAIL 3
+
+#define NUM_FILES  3
+#define CMD_OPTION '-'
+
+void usage_exit(void);
+double now(void);
+
+/* Wordle Feedback Matrix
+ * −−−−−−−−−−−−−−−
+ * Usage: ./wordle-matrix [-threads n] answers guesses output
+ *
+ * Computes the hint pattern of every guess against every answer of the
+ * same length, for lengths up to MAX_MATRIX_WORD_LEN, and writes them to
+ * output for wordle-server -matrix and offline analysis. Uses one thread
+ * per core unless told otherwise.
+ */
+int main(int argc, char** argv) {
+    int numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    char* files[NUM_FILES];
+    int numFiles = 0;
+    for (int i = 1; argv[i]; i++) {
+        if (argv[i][0] == CMD_OPTION) {
+            if (i + 1 >= argc || strcmp(argv[i], "-threads")
+                    || !parse_int(&numThreads, argv[++i])
+                    || numThreads < 1) {
+                usage_exit();
+            }
+        } else if (numFiles < NUM_FILES) {
+            files[numFiles++] = argv[i];
+        } else {
+            usage_exit();
+        }
+    }
+    if (numFiles != NUM_FILES) {
+        usage_exit();
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+
+    WordList* answers = init_word_list(files[0]);
+    WordList* guesses = init_word_list(files[1]);
+    if (!answers || !guesses) {
+        free_word_list(answers);
+        free_word_list(guesses);
+        return EXIT_FNF;
+    }
+    double pairs = 0;
+    for (int len = 1; len <= MAX_MATRIX_WORD_LEN; len++) {
+        pairs += (double)count_words(guesses, len) * count_words(answers, len);
+    }
+
+    double start = now();
+    bool ok = save_feedback_matrix(files[2], answers, guesses, numThreads);
+    double elapsed = now() - start;
+    if (ok) {
+        printf("%.0f pairs in %.3f s on %d threads: %.0f pairs/s, "
+               "%.0f pairs/s per thread\n",
+                pairs, elapsed, numThreads, pairs / elapsed,
+                pairs / elapsed / numThreads);
+    }
+    free_word_list(answers);
+    free_word_list(guesses);
+    return ok ? EXIT_OK : EXIT_WRITE_FAIL;
+}
+
+double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void usage_exit(void) {
+    fprintf(stderr,
+            "Usage: wordle-matrix [-threads n] answers guesses output\n");
+    exit(EXIT_BAD_USAGE);
+}
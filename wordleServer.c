@@ -1,4 +1,5 @@
 #include <arpa/inet.h>
+#include <errno.h>
 #include <netdb.h>
 #include <pthread.h>
 #include <signal.h>
@@ -7,8 +8,11 @@
 #include <time.h>
 #include <unistd.h>
 
-#include "util.h"
-#include "wordList.h"
+#include "metrics.h"
+#include "reactor.h"
+#include "trace.h"
+#include "wordleServer.h"
+#include "workerPool.h"
 
 #define DEFAULT_ANSWERS_PATH "default-answers.txt"
 #define DEFAULT_GUESSES_PATH "default-guesses.txt"
@@ -22,68 +26,69 @@
 
 #define STRFTIME_BUFFER 52
 
-#define MIN_TRIES     1
-#define MAX_TRIES     10
-#define DEFAULT_TRIES 6
-
-#define MIN_WORD_LEN     3
-#define MAX_WORD_LEN     9
-#define DEFAULT_WORD_LEN 5
-
 #define CMD_OPTION  '-'
-#define WRONG_GUESS '-'
 #define IP_DELIM    '.'
 
-typedef struct {
-    WordList* answers;
-    WordList* guesses;
-    char* hostname;
-    char* port;
-    int fd;
-} ServerDetails;
-
-typedef struct {
-    int connected;
-    int completed;
-    int won;
-    int lost;
-    pthread_mutex_t lock;
-    sigset_t set;
-} ServerStats;
+#define MIN_WORKERS 1
+#define MAX_WORKERS 1024
+#define PORT_BUFFER 8
 
-typedef struct {
-    ServerStats* stats;
-    ServerDetails* details;
-    int* fd;
-} Wrapper;
+#define MIN_CLIENTS        1
+#define MAX_CLIENTS        65536
+#define DEFAULT_MAXCLIENTS 256
+#define MIN_QUEUE          1
+#define MAX_QUEUE          1048576
+#define DEFAULT_QUEUE      1024
+#define MAX_BATCH          1024
+#define MAX_TIMEOUT        (7 * 24 * 3600)
+
+// Shuffles the daily answers unless -seed is given, so the schedule stays
+// the same across restarts.
+#define DAILY_SEED 0x5eed0fda11e5ull
 
 void usage_exit(void);
 void free_server_details(ServerDetails* details);
 ServerDetails* parse_arguments(int argc, char** argv);
+ServerMode parse_mode(char* mode);
+bool parse_seed(uint64_t* dest, char* src);
 bool open_server(ServerDetails* details);
 bool print_server_port(ServerDetails* details);
-ServerStats* init_server_stats(void);
+ServerStats* init_server_stats(int numShards, DailyClock* daily);
 void free_server_stats(ServerStats* stats);
 void* stats_thread(void* rawStats);
-void process_connections(ServerDetails* details, ServerStats* stats);
-void* client_thread(void* wrapper);
-void increment_stat(int* stat, pthread_mutex_t* lock);
-void print_prompt(FILE* stream, int wordLen, int tries);
-bool play_game(FILE* to, FILE* from, ServerDetails* details, int wordLen,
-        int tries, char* answer);
-char* get_hint(char* guess, char* answer, int wordLen);
-void game_menu(FILE* to, FILE* from, ServerDetails* details,
-        ServerStats* stats);
-void print_welcome(FILE* to);
-void fatal_server_error(int socketfd);
+void print_daily_stats(ServerStats* stats);
+void start_reloader(ServerDetails* details);
+void* reload_thread(void* rawDetails);
 
 /* Wordle Server
  * −−−−−−−−−−−−−−−
- * Usage: ./wordle-server [-answers file] [-guesses file] [hostname] [port]
+ * Usage: ./wordle-server [-answers file] [-guesses file] [-matrix file]
+ *                        [-mode threads|epoll] [-workers n]
+ *                        [-maxclients n] [-queue n] [-batch n]
+ *                        [-seed n] [-daily yyyy-mm-dd] [-idle seconds]
+ *                        [-gametime seconds] [-metrics port]
+ *                        [-players dir] [hostname] [port]
  */
 int main(int argc, char** argv) {
     ServerDetails* details = parse_arguments(argc, argv);
-    ServerStats* stats = init_server_stats();
+    // Signals are taken by their own threads, so no other thread may.
+    block_signals((int[]){SIGHUP, SIGUSR1, 0});
+#ifdef TRACE
+    start_tracer();
+#endif
+    start_reloader(details);
+    if (details->playersDir
+            && !(details->players = open_player_store(details->playersDir))) {
+        fprintf(stderr, "wordle-server: unable to open the player profiles "
+                        "in %s\n", details->playersDir);
+        free_server_details(details);
+        return EXIT_FNF;
+    }
+    // A shard for every reactor, or for every worker and the acceptor.
+    ServerStats* stats = init_server_stats(details->mode == MODE_EPOLL
+                    ? details->workers : details->maxClients + 1,
+            details->daily);
+    details->stats = stats;
 
     ignore_signals((int[]){SIGPIPE, 0});
 
@@ -94,238 +99,95 @@ int main(int argc, char** argv) {
         free_server_stats(stats);
         return EXIT_LISTEN_FAIL;
     }
-    srand(time(NULL));
-    process_connections(details, stats);
+    if (details->metricsPort && !start_metrics(details)) {
+        fprintf(stderr, "wordle-server: unable to serve metrics on port "
+                        "%s\n", details->metricsPort);
+        free_server_details(details);
+        free_server_stats(stats);
+        return EXIT_LISTEN_FAIL;
+    }
+    if (details->mode == MODE_EPOLL) {
+        run_reactors(details, stats);
+    } else {
+        run_worker_pool(details, stats);
+    }
 
     free_server_details(details);
     free_server_stats(stats);
     return EXIT_OK;
 }
 
-void process_connections(ServerDetails* details, ServerStats* stats) {
-    int fd;
-    pthread_t tid;
-    while (true) {
-        fd = accept(details->fd, NULL, NULL);
-        if (fd < 0) {
-            continue;
-        }
-
-        Wrapper* wrap = malloc(sizeof(Wrapper));
-        if (!wrap) {
-            fatal_server_error(fd);
-            continue;
-        }
-        wrap->fd = malloc(sizeof(int));
-        if (!wrap->fd) {
-            fatal_server_error(fd);
-            continue;
-        }
-        *wrap->fd = fd;
-        wrap->details = details;
-        wrap->stats = stats;
-
-        // Create and detach client handling thread.
-        if (pthread_create(&tid, NULL, client_thread, wrap)) {
-            fatal_server_error(fd);
-            continue;
-        }
-        pthread_detach(tid);
-    }
+void increment_stat(int* stat) {
+    __atomic_fetch_add(stat, 1, __ATOMIC_RELAXED);
 }
 
-void increment_stat(int* stat, pthread_mutex_t* lock) {
-    pthread_mutex_lock(lock);
-    (*stat)++;
-    pthread_mutex_unlock(lock);
-}
-void* client_thread(void* wrapper) {
-    // Unwrap the argument.
-    Wrapper* wrap = wrapper;
-    int fd = *wrap->fd;
-    ServerDetails* details = wrap->details;
-    ServerStats* stats = wrap->stats;
-    free(wrap->fd);
-    free(wrap);
-
-    increment_stat(&stats->connected, &stats->lock);
-    int fdDup = dup(fd);
-    FILE* to = fdopen(fdDup, "w");
-    FILE* from = fdopen(fd, "r");
-
-    game_menu(to, from, details, stats);
-
-    fclose(to);
-    fclose(from);
-
-    pthread_mutex_lock(&stats->lock);
-    stats->connected--;
-    stats->completed++;
-    pthread_mutex_unlock(&stats->lock);
-    return NULL;
+// Adds to a byte count only the shard's own thread writes.
+void add_bytes(uint64_t* stat, size_t bytes) {
+    __atomic_store_n(stat, __atomic_load_n(stat, __ATOMIC_RELAXED) + bytes,
+            __ATOMIC_RELAXED);
 }
 
-void print_welcome(FILE* to) {
-    fprintf(to, "Welcome to...\n");
-    fprintf(to, " _    _               _ _      \n");
-    fprintf(to, "| |  | |             | | |     \n");
-    fprintf(to, "| |  | | ___  _ __ __| | | ___ \n");
-    fprintf(to, "| |/\\| |/ _ \\| '__/ _` | |/ _ \\\n");
-    fprintf(to, "\\  /\\  / (_) | | | (_| | |  __/\n");
-    fprintf(to, " \\/  \\/ \\___/|_|  \\__,_|_|\\___|\n\n");
-    fflush(to);
+void client_connected(StatShard* stats) {
+    increment_stat(&stats->connected);
 }
 
-void game_menu(FILE* to, FILE* from, ServerDetails* details,
-        ServerStats* stats) {
-    char* input;
-    char* answer = NULL;
-    int option, wordLen = DEFAULT_WORD_LEN, tries = DEFAULT_TRIES, streak = 0;
-    bool won = false;
-    print_welcome(to);
-    while (true) {
-        fprintf(to, "Select one of the following:\n");
-        fprintf(to, "1. Play game (word length: %d, tries: %d, answer: %s)\n",
-                wordLen, tries, answer ? answer : "?????");
-        fprintf(to, "2. Change word length\n");
-        fprintf(to, "3. Change number of tries\n");
-        fprintf(to, "4. Cheat and set the answer\n");
-        fprintf(to, "5. Exit\n");
-        fflush(to);
-        if (!(input = read_line(from))) {
-            return;
-        }
-        if (!parse_int(&option, input)) {
-            free(input);
-            continue;
-        }
-        free(input);
-        switch (option) {
-            case 1:
-                if (!answer && !(answer = get_random_word(details->answers,
-                                         wordLen))) {
-                    perror("get_random_word");
-                    return;
-                }
-                won = play_game(to, from, details, wordLen, tries, answer);
-                free(answer);
-                answer = NULL;
-                increment_stat(won ? &stats->won : &stats->lost, &stats->lock);
-                streak = won ? streak + 1 : 0;
-                fprintf(to, "Win Streak: %d\n\n", streak);
-                break;
-            case 2:
-                if (!read_int(&wordLen, to, from, "Enter the word length",
-                            MIN_WORD_LEN, MAX_WORD_LEN)) {
-                    return;
-                }
-                break;
-            case 3:
-                if (!read_int(&tries, to, from, "Enter the number of tries",
-                            MIN_TRIES, MAX_TRIES)) {
-                    return;
-                }
-                break;
-            case 4:
-                fprintf(to, "Enter the answer word:\n");
-                fflush(to);
-                free(answer);
-                if (!(answer = read_line(from))) {
-                    return;
-                }
-                if (answer[0] == 0) {
-                    answer = NULL;
-                    wordLen = DEFAULT_WORD_LEN;
-                } else {
-                    wordLen = strlen(answer);
-                }
-                break;
-            case 5:
-                fprintf(to, "Goodbye...\n");
-                return;
-        }
-    }
-}
-
-bool play_game(FILE* to, FILE* from, ServerDetails* details, int wordLen,
-        int tries, char* answer) {
-    print_prompt(to, wordLen, tries);
-    char *guess, *hint;
-    while (tries && (guess = read_line(from))) {
-        if (parse_word(guess, wordLen, to)) {
-            if (!strcmp(guess, answer)) {
-                fprintf(to, "Correct!\n");
-                free(guess);
-                return true;
-            }
-            if (in_list(details->guesses, guess)) {
-                hint = get_hint(guess, answer, wordLen);
-                fprintf(to, "%s\n", hint);
-                free(hint);
-                tries--;
-            } else {
-                fprintf(to, "Word not found in the dictionary - try again.\n");
-            }
-        }
-        free(guess);
-        print_prompt(to, wordLen, tries);
-    }
-    fprintf(to, "Bad luck - the word is \"%s\".\n", answer);
-    return false;
+void client_disconnected(StatShard* stats) {
+    __atomic_fetch_sub(&stats->connected, 1, __ATOMIC_RELAXED);
+    increment_stat(&stats->completed);
 }
 
-char* get_hint(char* guess, char* answer, int wordLen) {
-    char* hint = calloc(wordLen + 1, sizeof(char));
-
-    // Setting the correct characters.
-    for (int i = 0; i < wordLen; i++) {
-        if (answer[i] == guess[i]) {
-            hint[i] = toupper(guess[i]);
-        }
+/* record_daily()
+ * −−−−−−−−−−−−−−−
+ * Adds a daily game to the shard's results, won in guesses or lost if that
+ * is 0. The first result for a new puzzle clears the previous day's. Word
+ * lengths the menu does not allow have no results.
+ */
+void record_daily(StatShard* stats, int puzzle, int wordLen, int guesses) {
+    if (wordLen < MIN_WORD_LEN || wordLen > MAX_WORD_LEN) {
+        return;
     }
-
-    int letterCount, displayedCount;
-    // Dealing with the wrong letters and letters not in the right position
-    for (int i = 0; i < wordLen; i++) {
-        if (!hint[i]) {
-            letterCount = 0;
-            displayedCount = 0;
-            for (int j = 0; j < wordLen; j++) {
-                // Counting the number of times the letter appears in the
-                // answer and how many times it appears in the hint.
-                if (guess[i] == answer[j]) {
-                    letterCount++;
-                }
-                if (guess[i] == tolower(hint[j])) {
-                    displayedCount++;
-                }
-            }
-            // Ensuring that the letter doesn't appear in the hint more
-            // than the answer
-            if (displayedCount < letterCount && strchr(answer, guess[i])) {
-                hint[i] = guess[i];
-                displayedCount++;
-            } else {
-                hint[i] = WRONG_GUESS;
+    if (__atomic_load_n(&stats->puzzle, __ATOMIC_RELAXED) != puzzle) {
+        for (int len = 0; len <= MAX_WORD_LEN - MIN_WORD_LEN; len++) {
+            for (int i = 0; i <= MAX_TRIES; i++) {
+                __atomic_store_n(&stats->daily[len][i], 0, __ATOMIC_RELAXED);
             }
         }
+        __atomic_store_n(&stats->puzzle, puzzle, __ATOMIC_RELAXED);
     }
-    return hint;
+    increment_stat(&stats->daily[wordLen - MIN_WORD_LEN][guesses]);
 }
 
-void print_prompt(FILE* stream, int wordLen, int tries) {
-    if (tries <= 0) {
+/* sum_daily()
+ * −−−−−−−−−−−−−−−
+ * Totals the results of a daily puzzle and word length over every shard
+ * into results, indexed as in StatShard. Like the other statistics this is
+ * a close rather than exact snapshot.
+ */
+void sum_daily(ServerStats* stats, int puzzle, int wordLen,
+        int results[MAX_TRIES + 1]) {
+    memset(results, 0, sizeof(int) * (MAX_TRIES + 1));
+    if (wordLen < MIN_WORD_LEN || wordLen > MAX_WORD_LEN) {
         return;
     }
-    fprintf(stream, "Enter a %d letter word ", wordLen);
-    if (tries == 1) {
-        fprintf(stream, "(last attempt):\n");
-    } else {
-        fprintf(stream, "(%d attempts remaining):\n", tries);
+    for (int i = 0; i < stats->numShards; i++) {
+        StatShard* shard = &stats->shards[i];
+        if (__atomic_load_n(&shard->puzzle, __ATOMIC_RELAXED) != puzzle) {
+            continue;
+        }
+        for (int j = 0; j <= MAX_TRIES; j++) {
+            results[j] += __atomic_load_n(
+                    &shard->daily[wordLen - MIN_WORD_LEN][j],
+                    __ATOMIC_RELAXED);
+        }
     }
-    fflush(stream);
 }
 
+/* stats_thread()
+ * −−−−−−−−−−−−−−−
+ * Prints the server statistics, summed over every shard, each time the
+ * server receives SIGHUP. The shards are read without stopping the threads
+ * that own them, so the totals are a close rather than exact snapshot.
+ */
 void* stats_thread(void* rawStats) {
     ServerStats* stats = rawStats;
     int sigNum;
@@ -335,24 +197,107 @@ void* stats_thread(void* rawStats) {
     size_t len;
     while (true) {
         sigwait(&stats->set, &sigNum);
-        pthread_mutex_lock(&stats->lock);
+        StatShard total;
+        memset(&total, 0, sizeof(StatShard));
+        for (int i = 0; i < stats->numShards; i++) {
+            StatShard* shard = &stats->shards[i];
+            total.connected += __atomic_load_n(&shard->connected,
+                    __ATOMIC_RELAXED);
+            total.completed += __atomic_load_n(&shard->completed,
+                    __ATOMIC_RELAXED);
+            total.won += __atomic_load_n(&shard->won, __ATOMIC_RELAXED);
+            total.lost += __atomic_load_n(&shard->lost, __ATOMIC_RELAXED);
+            total.rejected += __atomic_load_n(&shard->rejected,
+                    __ATOMIC_RELAXED);
+            total.timedOut += __atomic_load_n(&shard->timedOut,
+                    __ATOMIC_RELAXED);
+        }
         raw = time(NULL);
         local = localtime(&raw);
         len = strftime(buffer, STRFTIME_BUFFER, "%c", local);
         fprintf(stderr, "Server Stats at %s\n", len ? buffer : "????");
-        fprintf(stderr, "Connected clients: %d\n", stats->connected);
-        fprintf(stderr, "Completed clients: %d\n", stats->completed);
-        fprintf(stderr, "Games won:         %d\n", stats->won);
-        fprintf(stderr, "Games lost:        %d\n", stats->lost);
+        fprintf(stderr, "Connected clients: %d\n", total.connected);
+        fprintf(stderr, "Completed clients: %d\n", total.completed);
+        fprintf(stderr, "Games won:         %d\n", total.won);
+        fprintf(stderr, "Games lost:        %d\n", total.lost);
+        fprintf(stderr, "Rejected clients:  %d\n", total.rejected);
+        fprintf(stderr, "Timed out clients: %d\n", total.timedOut);
+#ifdef COUNT_ALLOCS
+        fprintf(stderr, "Heap allocations:  %zu\n", allocation_count());
+#endif
+        if (stats->daily) {
+            print_daily_stats(stats);
+        }
         fflush(stderr);
-        pthread_mutex_unlock(&stats->lock);
     }
     return NULL;
 }
 
-ServerStats* init_server_stats(void) {
+// Prints today's daily results for each word length that has been played.
+void print_daily_stats(ServerStats* stats) {
+    int puzzle = current_puzzle(stats->daily);
+    int results[MAX_TRIES + 1];
+    for (int len = MIN_WORD_LEN; len <= MAX_WORD_LEN; len++) {
+        sum_daily(stats, puzzle, len, results);
+        int played = 0;
+        for (int i = 0; i <= MAX_TRIES; i++) {
+            played += results[i];
+        }
+        if (!played) {
+            continue;
+        }
+        fprintf(stderr, "Daily puzzle #%d (%d letters): %d won, %d lost, "
+                        "by guesses", puzzle, len, played - results[0],
+                results[0]);
+        for (int i = 1; i <= MAX_TRIES; i++) {
+            fprintf(stderr, " %d", results[i]);
+        }
+        fprintf(stderr, "\n");
+    }
+}
+
+void start_reloader(ServerDetails* details) {
+    pthread_t tid;
+    pthread_create(&tid, NULL, reload_thread, details);
+    pthread_detach(tid);
+}
+
+/* reload_thread()
+ * −−−−−−−−−−−−−−−
+ * Reloads the word lists from their files each time the server receives
+ * SIGUSR1. Games in progress finish with the lists they started with and
+ * new games use the new ones, so no client is disconnected.
+ */
+void* reload_thread(void* rawDetails) {
+    ServerDetails* details = rawDetails;
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    int sigNum;
+    while (true) {
+        sigwait(&set, &sigNum);
+        if (!reload_dictionary(details->dictionaries)) {
+            fprintf(stderr, "wordle-server: reload failed, keeping the "
+                            "current word lists\n");
+            continue;
+        }
+        Dictionary* dictionary = acquire_dictionary(details->dictionaries);
+        fprintf(stderr, "Reloaded word lists (generation %d): %zu answers, "
+                        "%zu guesses\n",
+                dictionary->generation, dictionary->answers->size,
+                dictionary->guesses->size);
+        release_dictionary(dictionary);
+    }
+    return NULL;
+}
+
+ServerStats* init_server_stats(int numShards, DailyClock* daily) {
     ServerStats* stats = x_calloc(1, sizeof(ServerStats));
-    pthread_mutex_init(&stats->lock, NULL);
+    stats->daily = daily;
+    stats->shards = x_aligned_alloc(CACHE_LINE,
+            sizeof(StatShard) * numShards);
+    memset(stats->shards, 0, sizeof(StatShard) * numShards);
+    stats->numShards = numShards;
     sigemptyset(&stats->set);
     sigaddset(&stats->set, SIGHUP);
     pthread_sigmask(SIG_BLOCK, &stats->set, NULL);
@@ -365,11 +310,54 @@ ServerStats* init_server_stats(void) {
 }
 
 void free_server_stats(ServerStats* stats) {
-    pthread_mutex_destroy(&stats->lock);
+    free(stats->shards);
     free(stats);
 }
 
+/* open_server()
+ * −−−−−−−−−−−−−−−
+ * Opens a listening socket for each epoll reactor, or just one for the
+ * other modes. Reactors each get their own SO_REUSEPORT socket on the same
+ * port so the kernel spreads new clients between them.
+ *
+ * Returns: true if every socket is listening, otherwise false.
+ */
 bool open_server(ServerDetails* details) {
+    int numFds = details->mode == MODE_EPOLL ? details->workers : 1;
+    details->listenFds = x_malloc(sizeof(int) * numFds);
+    details->fd = open_listener(details->hostname, details->port,
+            numFds > 1);
+    if (details->fd < 0) {
+        return false;
+    }
+    details->listenFds[0] = details->fd;
+    if (!print_server_port(details)) {
+        return false;
+    }
+
+    // The rest must bind the port the first one was given.
+    struct sockaddr_in ad;
+    socklen_t len = sizeof(struct sockaddr_in);
+    char port[PORT_BUFFER];
+    if (getsockname(details->fd, (struct sockaddr*)&ad, &len)) {
+        return false;
+    }
+    snprintf(port, PORT_BUFFER, "%u", ntohs(ad.sin_port));
+    for (int i = 1; i < numFds; i++) {
+        if ((details->listenFds[i] = open_listener(details->hostname, port,
+                     true)) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* open_listener()
+ * −−−−−−−−−−−−−−−
+ * Returns: a socket listening on the given hostname and port, or -1 on
+ * failure.
+ */
+int open_listener(char* hostname, char* port, bool reusePort) {
     struct addrinfo* info = NULL;
     struct addrinfo hints;
     memset(&hints, 0, sizeof(struct addrinfo));
@@ -378,34 +366,39 @@ bool open_server(ServerDetails* details) {
     hints.ai_socktype = SOCK_STREAM;  // TCP
     hints.ai_flags = AI_PASSIVE;
 
-    if (getaddrinfo(details->hostname, details->port, &hints, &info)) {
-        return false;
+    if (getaddrinfo(hostname, port, &hints, &info)) {
+        return -1;
     }
 
     int fd = socket(AF_INET, SOCK_STREAM, 0);
     if (fd < 0) {
         freeaddrinfo(info);
-        return false;
+        return -1;
     }
 
-    // Allow address (port number) to be reused immediately
+    // Allow address (port number) to be reused immediately, and by several
+    // sockets at once if asked.
     int optVal = 1;
-    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &optVal, sizeof(int))) {
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &optVal, sizeof(int))
+            || (reusePort && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT,
+                                     &optVal, sizeof(int)))) {
         freeaddrinfo(info);
-        return false;
+        close(fd);
+        return -1;
     }
 
     if (bind(fd, (struct sockaddr*)info->ai_addr, sizeof(struct sockaddr))) {
         freeaddrinfo(info);
-        return false;
+        close(fd);
+        return -1;
     }
     freeaddrinfo(info);
 
     if (listen(fd, SOMAXCONN)) {
-        return false;
+        close(fd);
+        return -1;
     }
-    details->fd = fd;
-    return print_server_port(details);
+    return fd;
 }
 
 bool print_server_port(ServerDetails* details) {
@@ -430,9 +423,48 @@ bool print_server_port(ServerDetails* details) {
     return true;
 }
 
+ServerMode parse_mode(char* mode) {
+    if (!strcmp(mode, "threads")) {
+        return MODE_THREADS;
+    }
+    if (!strcmp(mode, "epoll")) {
+        return MODE_EPOLL;
+    }
+    usage_exit();
+    return MODE_THREADS;  // Never reach here
+}
+
+// Parses an unsigned 64-bit seed, in decimal or with a 0x or 0 prefix.
+bool parse_seed(uint64_t* dest, char* src) {
+    if (!*src || *src == '-') {
+        return false;
+    }
+    char* end;
+    errno = 0;
+    unsigned long long seed = strtoull(src, &end, 0);
+    if (*end || errno) {
+        return false;
+    }
+    *dest = seed;
+    return true;
+}
+
 ServerDetails* parse_arguments(int argc, char** argv) {
     char* answersPath = DEFAULT_ANSWERS_PATH;
     char* guessesPath = DEFAULT_GUESSES_PATH;
+    char* matrixPath = NULL;
+    ServerMode mode = MODE_THREADS;
+    int workers = MIN_WORKERS;
+    int maxClients = DEFAULT_MAXCLIENTS;
+    int queueSize = DEFAULT_QUEUE;
+    int maxBatch = 0;
+    int idleTimeout = 0;
+    int gameTimeout = 0;
+    char* metricsPort = NULL;
+    char* playersDir = NULL;
+    uint64_t seed = 0;
+    bool seedFound = false;
+    DailyClock* daily = NULL;
     char* hostname = DEFAULT_HOSTNAME;
     char* port = DEFAULT_PORT;
 
@@ -447,6 +479,55 @@ ServerDetails* parse_arguments(int argc, char** argv) {
                 answersPath = argv[++i];
             } else if (!strcmp(argv[i], "-guesses")) {
                 guessesPath = argv[++i];
+            } else if (!strcmp(argv[i], "-matrix")) {
+                matrixPath = argv[++i];
+            } else if (!strcmp(argv[i], "-mode")) {
+                mode = parse_mode(argv[++i]);
+            } else if (!strcmp(argv[i], "-workers")) {
+                if (!parse_int(&workers, argv[++i]) || workers < MIN_WORKERS
+                        || workers > MAX_WORKERS) {
+                    usage_exit();
+                }
+            } else if (!strcmp(argv[i], "-maxclients")) {
+                if (!parse_int(&maxClients, argv[++i])
+                        || maxClients < MIN_CLIENTS
+                        || maxClients > MAX_CLIENTS) {
+                    usage_exit();
+                }
+            } else if (!strcmp(argv[i], "-queue")) {
+                if (!parse_int(&queueSize, argv[++i]) || queueSize < MIN_QUEUE
+                        || queueSize > MAX_QUEUE) {
+                    usage_exit();
+                }
+            } else if (!strcmp(argv[i], "-batch")) {
+                if (!parse_int(&maxBatch, argv[++i]) || maxBatch < 0
+                        || maxBatch > MAX_BATCH) {
+                    usage_exit();
+                }
+            } else if (!strcmp(argv[i], "-seed")) {
+                if (!parse_seed(&seed, argv[++i])) {
+                    usage_exit();
+                }
+                seedFound = true;
+            } else if (!strcmp(argv[i], "-idle")) {
+                if (!parse_int(&idleTimeout, argv[++i]) || idleTimeout < 0
+                        || idleTimeout > MAX_TIMEOUT) {
+                    usage_exit();
+                }
+            } else if (!strcmp(argv[i], "-gametime")) {
+                if (!parse_int(&gameTimeout, argv[++i]) || gameTimeout < 0
+                        || gameTimeout > MAX_TIMEOUT) {
+                    usage_exit();
+                }
+            } else if (!strcmp(argv[i], "-metrics")) {
+                metricsPort = argv[++i];
+            } else if (!strcmp(argv[i], "-players")) {
+                playersDir = argv[++i];
+            } else if (!strcmp(argv[i], "-daily")) {
+                free(daily);
+                if (!(daily = init_daily_clock(argv[++i]))) {
+                    usage_exit();
+                }
             } else {
                 usage_exit();
             }
@@ -465,9 +546,21 @@ ServerDetails* parse_arguments(int argc, char** argv) {
     ServerDetails* details = x_calloc(1, sizeof(ServerDetails));
     details->hostname = hostname;
     details->port = port;
-    details->answers = init_word_list(answersPath);
-    details->guesses = init_word_list(guessesPath);
-    if (!details->answers || !details->guesses) {
+    details->mode = mode;
+    details->workers = workers;
+    details->maxClients = maxClients;
+    details->queueSize = queueSize;
+    details->maxBatch = maxBatch;
+    details->idleTimeout = idleTimeout;
+    details->gameTimeout = gameTimeout;
+    details->metricsPort = metricsPort;
+    details->playersDir = playersDir;
+    details->seed = seedFound ? seed : random_seed();
+    details->daily = daily;
+    details->dictionaries = init_dictionary_store(answersPath, guessesPath,
+            matrixPath, MIN_WORD_LEN, MAX_WORD_LEN, daily != NULL,
+            seedFound ? seed : DAILY_SEED);
+    if (!details->dictionaries) {
         free_server_details(details);
         exit(EXIT_FNF);
     }
@@ -479,19 +572,18 @@ void free_server_details(ServerDetails* details) {
     if (!details) {
         return;
     }
-    free_word_list(details->answers);
-    free_word_list(details->guesses);
+    free_dictionary_store(details->dictionaries);
+    free(details->daily);
+    free(details->listenFds);
     free(details);
 }
 
 void usage_exit(void) {
     fprintf(stderr, "Usage: wordle-server [-answers file] [-guesses file] "
+                    "[-matrix file] [-mode threads|epoll] [-workers n] "
+                    "[-maxclients n] [-queue n] [-batch n] [-seed n] "
+                    "[-daily yyyy-mm-dd] [-idle seconds] "
+                    "[-gametime seconds] [-metrics port] [-players dir] "
                     "[hostname] [port]\n");
     exit(EXIT_BAD_USAGE);
 }
-
-void fatal_server_error(int socketfd) {
-    char* msg = "A fatal server error occured :(. Try again later\n";
-    write(socketfd, msg, strlen(msg));
-    close(socketfd);
-}
@@ -0,0 +1,90 @@
+#ifndef WORDLE_SERVER_H
+#define WORDLE_SERVER_H
+
+#include <pthread.h>
+#include <signal.h>
+
+#include "daily.h"
+#include "dictionary.h"
+#include "histogram.h"
+#include "playerStore.h"
+#include "util.h"
+
+#define MIN_TRIES     1
+#define MAX_TRIES     10
+#define DEFAULT_TRIES 6
+
+#define MIN_WORD_LEN     3
+#define MAX_WORD_LEN     9
+#define DEFAULT_WORD_LEN 5
+
+#define CACHE_LINE 64
+
+typedef enum {
+    MODE_THREADS,  // One blocking thread per client
+    MODE_EPOLL,    // Non-blocking clients multiplexed by an epoll reactor
+} ServerMode;
+
+// Statistics kept by one reactor or worker thread. Only that thread adds to
+// them, with relaxed atomics, and each shard starts on a cache line of its
+// own so threads never contend for one.
+typedef struct {
+    int connected;
+    int completed;
+    int won;
+    int lost;
+    int rejected;  // Turned away as the server was busy
+    int timedOut;  // Closed for being idle or out of time
+    int puzzle;    // The daily puzzle the results below are for
+    // Daily results for each word length by the guesses each win took, with
+    // losses counted at 0.
+    int daily[MAX_WORD_LEN - MIN_WORD_LEN + 1][MAX_TRIES + 1];
+    int games[MAX_LIST_WORD_LEN + 1];  // Games finished, by word length
+    uint64_t bytesIn;
+    uint64_t bytesOut;
+    // Nanoseconds to judge each guess and to find it in the guesses list,
+    // timed only while there is a metrics listener.
+    Histogram guessTimes;
+    Histogram lookupTimes;
+} __attribute__((aligned(CACHE_LINE))) StatShard;
+
+typedef struct {
+    StatShard* shards;
+    int numShards;
+    sigset_t set;
+    DailyClock* daily;
+    int queued;  // Clients waiting for a worker
+} ServerStats;
+
+typedef struct {
+    DictionaryStore* dictionaries;  // The word lists, reloaded on SIGUSR1
+    char* hostname;
+    char* port;
+    ServerMode mode;
+    int workers;     // Number of epoll reactors
+    int maxClients;  // Number of worker threads, each serving one client
+    int queueSize;   // Clients that may wait for a worker before rejection
+    int maxBatch;    // Most guesses in one batch, or 0 to refuse batches
+    int idleTimeout;  // Seconds a client may send nothing, or 0 for ever
+    int gameTimeout;  // Seconds a game may last, or 0 for ever
+    uint64_t seed;      // For the answers, from -seed or getrandom()
+    uint64_t sessions;  // Sessions started, each a stream of seed
+    DailyClock* daily;  // Numbers the daily puzzles, or NULL to play random
+    ServerStats* stats;
+    char* metricsPort;  // For the metrics listener, or NULL for none
+    char* playersDir;      // Where player profiles are kept, or NULL
+    PlayerStore* players;  // Opened from playersDir, or NULL for no logins
+    int* listenFds;  // One SO_REUSEPORT socket per reactor
+    int fd;
+} ServerDetails;
+
+int open_listener(char* hostname, char* port, bool reusePort);
+void increment_stat(int* stat);
+void add_bytes(uint64_t* stat, size_t bytes);
+void client_connected(StatShard* stats);
+void client_disconnected(StatShard* stats);
+void record_daily(StatShard* stats, int puzzle, int wordLen, int guesses);
+void sum_daily(ServerStats* stats, int puzzle, int wordLen,
+        int results[MAX_TRIES + 1]);
+
+#endif  // WORDLE_SERVER_H
@@ -0,0 +1,664 @@
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hint.h"
+#include "util.h"
+#include "wordList.h"
+
+#define DEFAULT_ANSWERS_PATH "default-answers.txt"
+
+#define EXIT_OK        0
+#define EXIT_BAD_USAGE 1
+#define EXIT_FNF       2
+#define EXIT_NOT_WORD  3
+
+#define DEFAULT_TRIES    6
+#define MAX_TRIES        32     // Games are also cut short here
+#define MAX_THREADS      1024
+#define MAX_ANSWERS      65536  // Pattern ids must fit in uint16_t
+#define ROWS_PER_TASK    16
+#define GUESSES_PER_TASK 64
+#define SET_BITS         64
+#define NO_ANSWER        SIZE_MAX
+#define NUMBER_BUFFER    24
+
+#define CMD_OPTION '-'
+
+typedef enum {
+    SCORE_ENTROPY,    // Most expected information
+    SCORE_REMAINING,  // Fewest expected candidates left
+} Scoring;
+
+typedef struct {
+    size_t guess;
+    double cost;  // Lower is better
+    bool candidate;
+} Choice;
+
+/* Everything needed to play every answer of one length. Each guess row of
+ * patterns holds ids for the hints of that guess against every answer.
+ * The ids are numbered densely per row, so they index arrays of at most
+ * numAnswers entries whatever the word length. Candidate sets are bitsets
+ * over the answers, split by hint at every node of the game tree.
+ */
+typedef struct {
+    int wordLen;
+    Scoring scoring;
+    int numThreads;
+    WordList* answers;
+    size_t numAnswers;
+    size_t numGuesses;
+    size_t setWords;      // uint64_t words per candidate set
+    char** guesses;       // The guess list, then answers missing from it
+    size_t* guessAnswer;  // Position of each guess among the answers
+    size_t* answerGuess;  // Position of each answer among the guesses
+    uint16_t* patterns;   // numGuesses x numAnswers pattern ids
+    double* costs;        // Cost of a hint shared by n candidates
+    uint8_t* results;     // Guesses taken for each answer, 0 if unsolved
+    size_t* paths;        // The guesses made for each answer, MAX_TRIES each
+    size_t firstGuess;
+    uint64_t* rootSet;    // The root node, whose work is shared out
+    uint64_t* children;
+    size_t* childSizes;
+    size_t numTasks;
+    size_t nextTask;
+} Solver;
+
+typedef struct {
+    Solver* solver;
+    uint32_t* counts;   // Candidates per pattern id
+    uint32_t* touched;  // Pattern ids seen
+    int32_t* slots;     // Child of each pattern id, or -1
+    uint64_t* keys;
+    Choice best;
+} Worker;
+
+typedef struct {
+    size_t answers;
+    size_t guesses;  // Taken over every game
+    size_t failed;   // Games that took more than the tries allowed
+    int worst;
+} Summary;
+
+void usage_exit(void);
+double now(void);
+Scoring parse_scoring(char* scoring);
+Solver* init_solver(WordList* answers, WordList* guesses, int wordLen,
+        Scoring scoring, int numThreads);
+void free_solver(Solver* solver);
+void run_threads(Worker* workers, void* (*func)(void*));
+int compare_keys(const void* a, const void* b);
+void* fill_thread(void* rawWorker);
+void fill_rows(Worker* worker, size_t firstRow, size_t lastRow);
+void* root_thread(void* rawWorker);
+void* subtree_thread(void* rawWorker);
+void solve(Solver* solver);
+void solve_node(Worker* worker, uint64_t* set, size_t size, int depth);
+size_t list_set(Solver* solver, uint64_t* set, uint32_t* list);
+void score_guesses(Worker* worker, uint64_t* set, uint32_t* list,
+        size_t size, size_t first, size_t last, Choice* best);
+bool better_choice(Choice* a, Choice* b);
+size_t split(Worker* worker, uint32_t* list, size_t size, size_t guess,
+        int depth, uint64_t** children, size_t** childSizes);
+void add_results(Solver* solver, int tries, Summary* summary);
+void print_summary(char* length, char* guesses, char* first,
+        Summary* summary, double elapsed);
+void print_game(Solver* solver, size_t answer);
+
+/* Wordle Solve
+ * −−−−−−−−−−−−−−−
+ * Usage: ./wordle-solve [-answers file] [-guesses file] [-length n]
+ *                       [-score entropy|remaining] [-threads n]
+ *                       [-tries n] [word ...]
+ *
+ * Plays every answer of every length up to MAX_PATTERN_LEN, beyond which
+ * hints no longer have distinct patterns (or just -length n), with the
+ * same word lists and hints as wordle-server, and reports the average and
+ * worst number of guesses taken per length. Each guess is the word that
+ * leaves the most expected information (entropy), or the fewest expected
+ * candidates (remaining), preferring possible answers on ties. Given words,
+ * it shows the games for those answers instead.
+ */
+int main(int argc, char** argv) {
+    char* answersPath = DEFAULT_ANSWERS_PATH;
+    char* guessesPath = NULL;
+    Scoring scoring = SCORE_ENTROPY;
+    int numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    int tries = DEFAULT_TRIES;
+    int onlyLen = 0;
+    int i;
+    for (i = 1; argv[i] && argv[i][0] == CMD_OPTION; i += 2) {
+        if (!argv[i + 1]) {
+            usage_exit();
+        } else if (!strcmp(argv[i], "-answers")) {
+            answersPath = argv[i + 1];
+        } else if (!strcmp(argv[i], "-guesses")) {
+            guessesPath = argv[i + 1];
+        } else if (!strcmp(argv[i], "-score")) {
+            scoring = parse_scoring(argv[i + 1]);
+        } else if (!strcmp(argv[i], "-threads")) {
+            if (!parse_int(&numThreads, argv[i + 1]) || numThreads < 1
+                    || numThreads > MAX_THREADS) {
+                usage_exit();
+            }
+        } else if (!strcmp(argv[i], "-tries")) {
+            if (!parse_int(&tries, argv[i + 1]) || tries < 1
+                    || tries > MAX_TRIES) {
+                usage_exit();
+            }
+        } else if (!strcmp(argv[i], "-length")) {
+            if (!parse_int(&onlyLen, argv[i + 1]) || onlyLen < 1
+                    || onlyLen > MAX_PATTERN_LEN) {
+                usage_exit();
+            }
+        } else {
+            usage_exit();
+        }
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+
+    WordList* answers = init_word_list(answersPath);
+    WordList* guesses = answers;
+    if (guessesPath && strcmp(guessesPath, answersPath)) {
+        guesses = init_word_list(guessesPath);
+    }
+    if (!answers || !guesses) {
+        free_word_list(answers);
+        if (guesses != answers) {
+            free_word_list(guesses);
+        }
+        return EXIT_FNF;
+    }
+
+    int status = EXIT_OK;
+    Solver* solvers[MAX_LIST_WORD_LEN + 1] = {NULL};
+    if (argv[i]) {
+        // Show the games for the given answers.
+        for (; argv[i]; i++) {
+            size_t pos;
+            int len = strlen(argv[i]);
+            if (parse_word(argv[i], -1) != WORD_OK
+                    || !find_word(answers, argv[i], &pos)) {
+                fprintf(stderr, "%s: not an answer\n", argv[i]);
+                status = EXIT_NOT_WORD;
+                continue;
+            }
+            if (len > MAX_PATTERN_LEN) {
+                fprintf(stderr, "%s: longer than %d letters\n", argv[i],
+                        MAX_PATTERN_LEN);
+                status = EXIT_NOT_WORD;
+                continue;
+            }
+            if (!solvers[len]) {
+                solvers[len] = init_solver(answers, guesses, len, scoring,
+                        numThreads);
+                solve(solvers[len]);
+            }
+            print_game(solvers[len], pos);
+        }
+    } else {
+        printf("%6s %8s %8s %-18s %8s %6s %6s %8s\n", "length", "answers",
+                "guesses", "first", "average", "worst", "failed",
+                "seconds");
+        Summary all = {0};
+        double start = now();
+        for (int len = 1; len <= MAX_PATTERN_LEN; len++) {
+            if (!count_words(answers, len) || (onlyLen && len != onlyLen)) {
+                continue;
+            }
+            double lenStart = now();
+            Solver* solver = init_solver(answers, guesses, len, scoring,
+                    numThreads);
+            solve(solver);
+            Summary summary = {0};
+            add_results(solver, tries, &summary);
+            add_results(solver, tries, &all);
+            char length[NUMBER_BUFFER], numGuesses[NUMBER_BUFFER];
+            sprintf(length, "%d", len);
+            sprintf(numGuesses, "%zu", solver->numGuesses);
+            print_summary(length, numGuesses,
+                    solver->guesses[solver->firstGuess], &summary,
+                    now() - lenStart);
+            free_solver(solver);
+        }
+        print_summary("all", "", "", &all, now() - start);
+    }
+
+    for (int len = 0; len <= MAX_LIST_WORD_LEN; len++) {
+        free_solver(solvers[len]);
+    }
+    if (guesses != answers) {
+        free_word_list(guesses);
+    }
+    free_word_list(answers);
+    return status;
+}
+
+void usage_exit(void) {
+    fprintf(stderr, "Usage: wordle-solve [-answers file] [-guesses file] "
+                    "[-length n] [-score entropy|remaining] [-threads n] "
+                    "[-tries n] [word ...]\n");
+    exit(EXIT_BAD_USAGE);
+}
+
+double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+Scoring parse_scoring(char* scoring) {
+    if (!strcmp(scoring, "entropy")) {
+        return SCORE_ENTROPY;
+    } else if (!strcmp(scoring, "remaining")) {
+        return SCORE_REMAINING;
+    }
+    usage_exit();
+    return SCORE_ENTROPY;
+}
+
+/* init_solver()
+ * −−−−−−−−−−−−−−−
+ * Sets up a solver for the answers of length wordLen. Guesses may be any
+ * word of that length in the guess list, or any answer, as otherwise some
+ * answers could never be guessed.
+ */
+Solver* init_solver(WordList* answers, WordList* guesses, int wordLen,
+        Scoring scoring, int numThreads) {
+    Solver* solver = x_calloc(1, sizeof(Solver));
+    solver->wordLen = wordLen;
+    solver->scoring = scoring;
+    solver->numThreads = numThreads;
+    solver->answers = answers;
+    solver->numAnswers = count_words(answers, wordLen);
+    if (solver->numAnswers > MAX_ANSWERS) {
+        fprintf(stderr, "wordle-solve: more than %d answers of length %d\n",
+                MAX_ANSWERS, wordLen);
+        exit(EXIT_BAD_USAGE);
+    }
+    solver->setWords = (solver->numAnswers + SET_BITS - 1) / SET_BITS;
+
+    size_t listed = guesses == answers ? 0 : count_words(guesses, wordLen);
+    size_t maxGuesses = listed + solver->numAnswers;
+    solver->guesses = x_malloc(sizeof(char*) * maxGuesses);
+    solver->guessAnswer = x_malloc(sizeof(size_t) * maxGuesses);
+    solver->answerGuess = x_malloc(sizeof(size_t) * solver->numAnswers);
+    for (size_t g = 0; g < listed; g++) {
+        size_t pos;
+        solver->guesses[g] = get_word(guesses, wordLen, g);
+        solver->guessAnswer[g] = find_word(answers, solver->guesses[g], &pos)
+                ? pos : NO_ANSWER;
+    }
+    solver->numGuesses = listed;
+    for (size_t a = 0; a < solver->numAnswers; a++) {
+        size_t pos;
+        char* answer = get_word(answers, wordLen, a);
+        if (listed && find_word(guesses, answer, &pos)) {
+            solver->answerGuess[a] = pos;
+            continue;
+        }
+        solver->answerGuess[a] = solver->numGuesses;
+        solver->guesses[solver->numGuesses] = answer;
+        solver->guessAnswer[solver->numGuesses++] = a;
+    }
+
+    solver->patterns = x_malloc(
+            sizeof(uint16_t) * solver->numGuesses * solver->numAnswers);
+    solver->costs = x_malloc(sizeof(double) * (solver->numAnswers + 1));
+    for (size_t n = 0; n <= solver->numAnswers; n++) {
+        solver->costs[n] = scoring == SCORE_ENTROPY
+                ? (n ? n * log2(n) : 0) : (double)n * n;
+    }
+    solver->results = x_calloc(solver->numAnswers, sizeof(uint8_t));
+    solver->paths = x_calloc(solver->numAnswers * MAX_TRIES, sizeof(size_t));
+    return solver;
+}
+
+void free_solver(Solver* solver) {
+    if (!solver) {
+        return;
+    }
+    free(solver->guesses);
+    free(solver->guessAnswer);
+    free(solver->answerGuess);
+    free(solver->patterns);
+    free(solver->costs);
+    free(solver->results);
+    free(solver->paths);
+    free(solver);
+}
+
+/* run_threads()
+ * −−−−−−−−−−−−−−−
+ * Runs func on every worker, each on its own thread but the first, which
+ * runs on this one, and waits for them all to return.
+ */
+void run_threads(Worker* workers, void* (*func)(void*)) {
+    int numThreads = workers[0].solver->numThreads;
+    pthread_t* tids = x_malloc(sizeof(pthread_t) * numThreads);
+    int started = 0;
+    while (started < numThreads - 1 && !pthread_create(&tids[started], NULL,
+                                               func, &workers[started + 1])) {
+        started++;
+    }
+    func(&workers[0]);
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    free(tids);
+}
+
+int compare_keys(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+void* fill_thread(void* rawWorker) {
+    Worker* worker = rawWorker;
+    Solver* solver = worker->solver;
+    size_t task;
+    while ((task = __atomic_fetch_add(&solver->nextTask, 1, __ATOMIC_RELAXED))
+            < solver->numTasks) {
+        size_t lastRow = (task + 1) * ROWS_PER_TASK;
+        fill_rows(worker, task * ROWS_PER_TASK,
+                lastRow < solver->numGuesses ? lastRow : solver->numGuesses);
+    }
+    return NULL;
+}
+
+/* fill_rows()
+ * −−−−−−−−−−−−−−−
+ * Computes the hints of the given guesses against every answer, numbering
+ * the distinct hints of each guess from 0 in pattern order.
+ */
+void fill_rows(Worker* worker, size_t firstRow, size_t lastRow) {
+    Solver* solver = worker->solver;
+    char hint[MAX_LIST_WORD_LEN + 1];
+    for (size_t row = firstRow; row < lastRow; row++) {
+        for (size_t a = 0; a < solver->numAnswers; a++) {
+            uint64_t pattern = get_hint(solver->guesses[row],
+                    get_word(solver->answers, solver->wordLen, a),
+                    solver->wordLen, hint);
+            worker->keys[a] = pattern << 32 | a;
+        }
+        qsort(worker->keys, solver->numAnswers, sizeof(uint64_t),
+                compare_keys);
+        uint16_t* ids = solver->patterns + row * solver->numAnswers;
+        uint16_t id = 0;
+        for (size_t i = 0; i < solver->numAnswers; i++) {
+            if (i && worker->keys[i] >> 32 != worker->keys[i - 1] >> 32) {
+                id++;
+            }
+            ids[worker->keys[i] & UINT32_MAX] = id;
+        }
+    }
+}
+
+void* root_thread(void* rawWorker) {
+    Worker* worker = rawWorker;
+    Solver* solver = worker->solver;
+    uint32_t* list = x_malloc(sizeof(uint32_t) * solver->numAnswers);
+    size_t size = list_set(solver, solver->rootSet, list);
+    size_t task;
+    while ((task = __atomic_fetch_add(&solver->nextTask, 1, __ATOMIC_RELAXED))
+            < solver->numTasks) {
+        size_t last = (task + 1) * GUESSES_PER_TASK;
+        score_guesses(worker, solver->rootSet, list, size,
+                task * GUESSES_PER_TASK,
+                last < solver->numGuesses ? last : solver->numGuesses,
+                &worker->best);
+    }
+    free(list);
+    return NULL;
+}
+
+void* subtree_thread(void* rawWorker) {
+    Worker* worker = rawWorker;
+    Solver* solver = worker->solver;
+    size_t task;
+    while ((task = __atomic_fetch_add(&solver->nextTask, 1, __ATOMIC_RELAXED))
+            < solver->numTasks) {
+        solve_node(worker, solver->children + task * solver->setWords,
+                solver->childSizes[task], 1);
+    }
+    return NULL;
+}
+
+/* solve()
+ * −−−−−−−−−−−−−−−
+ * Plays every answer, filling in results and paths. The hints are
+ * computed and the first guess scored by all threads together, then the
+ * games that follow each hint to the first guess are handed out to them.
+ */
+void solve(Solver* solver) {
+    Worker* workers = x_calloc(solver->numThreads, sizeof(Worker));
+    for (int i = 0; i < solver->numThreads; i++) {
+        workers[i].solver = solver;
+        workers[i].counts = x_calloc(solver->numAnswers, sizeof(uint32_t));
+        workers[i].touched = x_malloc(sizeof(uint32_t) * solver->numAnswers);
+        workers[i].slots = x_malloc(sizeof(int32_t) * solver->numAnswers);
+        memset(workers[i].slots, -1, sizeof(int32_t) * solver->numAnswers);
+        workers[i].keys = x_malloc(sizeof(uint64_t) * solver->numAnswers);
+        workers[i].best.guess = NO_ANSWER;
+    }
+
+    solver->nextTask = 0;
+    solver->numTasks = (solver->numGuesses + ROWS_PER_TASK - 1)
+            / ROWS_PER_TASK;
+    run_threads(workers, fill_thread);
+
+    solver->rootSet = x_calloc(solver->setWords, sizeof(uint64_t));
+    for (size_t a = 0; a < solver->numAnswers; a++) {
+        solver->rootSet[a / SET_BITS] |= 1ull << a % SET_BITS;
+    }
+    Choice best = {.guess = solver->answerGuess[0]};
+    if (solver->numAnswers > 2) {
+        solver->nextTask = 0;
+        solver->numTasks = (solver->numGuesses + GUESSES_PER_TASK - 1)
+                / GUESSES_PER_TASK;
+        run_threads(workers, root_thread);
+        best = workers[0].best;
+        for (int i = 1; i < solver->numThreads; i++) {
+            if (better_choice(&workers[i].best, &best)) {
+                best = workers[i].best;
+            }
+        }
+    }
+    solver->firstGuess = best.guess;
+
+    uint32_t* list = x_malloc(sizeof(uint32_t) * solver->numAnswers);
+    size_t size = list_set(solver, solver->rootSet, list);
+    solver->nextTask = 0;
+    solver->numTasks = split(&workers[0], list, size, best.guess, 0,
+            &solver->children, &solver->childSizes);
+    run_threads(workers, subtree_thread);
+    free(list);
+
+    free(solver->rootSet);
+    free(solver->children);
+    free(solver->childSizes);
+    for (int i = 0; i < solver->numThreads; i++) {
+        free(workers[i].counts);
+        free(workers[i].touched);
+        free(workers[i].slots);
+        free(workers[i].keys);
+    }
+    free(workers);
+}
+
+/* solve_node()
+ * −−−−−−−−−−−−−−−
+ * Plays the size answers in set, each of which has had depth guesses, by
+ * choosing the best next guess and splitting the set by its hints.
+ */
+void solve_node(Worker* worker, uint64_t* set, size_t size, int depth) {
+    Solver* solver = worker->solver;
+    if (depth >= MAX_TRIES) {
+        return;
+    }
+    uint32_t* list = x_malloc(sizeof(uint32_t) * size);
+    list_set(solver, set, list);
+    Choice best = {.guess = solver->answerGuess[list[0]]};
+    if (size > 2) {
+        best.guess = NO_ANSWER;
+        score_guesses(worker, set, list, size, 0, solver->numGuesses, &best);
+    }
+    uint64_t* children;
+    size_t* childSizes;
+    size_t numChildren = split(worker, list, size, best.guess, depth,
+            &children, &childSizes);
+    free(list);
+    for (size_t i = 0; i < numChildren; i++) {
+        solve_node(worker, children + i * solver->setWords, childSizes[i],
+                depth + 1);
+    }
+    free(children);
+    free(childSizes);
+}
+
+/* list_set()
+ * −−−−−−−−−−−−−−−
+ * Writes the positions of the answers in set to list.
+ *
+ * Returns: the number of answers in set.
+ */
+size_t list_set(Solver* solver, uint64_t* set, uint32_t* list) {
+    size_t size = 0;
+    for (size_t i = 0; i < solver->setWords; i++) {
+        for (uint64_t bits = set[i]; bits; bits &= bits - 1) {
+            list[size++] = i * SET_BITS + __builtin_ctzll(bits);
+        }
+    }
+    return size;
+}
+
+/* score_guesses()
+ * −−−−−−−−−−−−−−−
+ * Scores guesses first to last - 1 against the candidates in set (also
+ * given as list), replacing best with any better choice. A guess costs the
+ * sum over its hints of the cost of the candidates sharing each hint, so
+ * guesses that split the candidates more evenly cost less. Guesses that
+ * can neither split the candidates nor win are skipped.
+ */
+void score_guesses(Worker* worker, uint64_t* set, uint32_t* list,
+        size_t size, size_t first, size_t last, Choice* best) {
+    Solver* solver = worker->solver;
+    for (size_t g = first; g < last; g++) {
+        uint16_t* row = solver->patterns + g * solver->numAnswers;
+        size_t touched = 0;
+        for (size_t i = 0; i < size; i++) {
+            uint16_t id = row[list[i]];
+            if (!worker->counts[id]++) {
+                worker->touched[touched++] = id;
+            }
+        }
+        Choice choice = {.guess = g, .cost = 0};
+        for (size_t i = 0; i < touched; i++) {
+            choice.cost += solver->costs[worker->counts[worker->touched[i]]];
+            worker->counts[worker->touched[i]] = 0;
+        }
+        size_t answer = solver->guessAnswer[g];
+        choice.candidate = answer != NO_ANSWER
+                && set[answer / SET_BITS] >> answer % SET_BITS & 1;
+        if ((touched > 1 || choice.candidate)
+                && better_choice(&choice, best)) {
+            *best = choice;
+        }
+    }
+}
+
+bool better_choice(Choice* a, Choice* b) {
+    if (a->guess == NO_ANSWER || b->guess == NO_ANSWER) {
+        return b->guess == NO_ANSWER;
+    } else if (a->cost != b->cost) {
+        return a->cost < b->cost;
+    }
+    if (a->candidate != b->candidate) {
+        return a->candidate;
+    }
+    return a->guess < b->guess;
+}
+
+/* split()
+ * −−−−−−−−−−−−−−−
+ * Makes guess for every answer in list, recording it in their paths and
+ * ending the game of the answer it matches. The other answers are split
+ * into one new set per hint.
+ *
+ * Returns: the number of sets, which the caller must free along with
+ * childSizes.
+ */
+size_t split(Worker* worker, uint32_t* list, size_t size, size_t guess,
+        int depth, uint64_t** children, size_t** childSizes) {
+    Solver* solver = worker->solver;
+    uint16_t* row = solver->patterns + guess * solver->numAnswers;
+    size_t won = solver->guessAnswer[guess];
+    size_t numChildren = 0;
+    for (size_t i = 0; i < size; i++) {
+        solver->paths[list[i] * MAX_TRIES + depth] = guess;
+        if (list[i] == won) {
+            solver->results[won] = depth + 1;
+        } else if (worker->slots[row[list[i]]] < 0) {
+            worker->slots[row[list[i]]] = numChildren;
+            worker->touched[numChildren++] = row[list[i]];
+        }
+    }
+    *children = x_calloc(numChildren + 1, sizeof(uint64_t) * solver->setWords);
+    *childSizes = x_calloc(numChildren + 1, sizeof(size_t));
+    for (size_t i = 0; i < size; i++) {
+        if (list[i] == won) {
+            continue;
+        }
+        int32_t child = worker->slots[row[list[i]]];
+        (*children)[child * solver->setWords + list[i] / SET_BITS]
+                |= 1ull << list[i] % SET_BITS;
+        (*childSizes)[child]++;
+    }
+    for (size_t i = 0; i < numChildren; i++) {
+        worker->slots[worker->touched[i]] = -1;
+    }
+    return numChildren;
+}
+
+void add_results(Solver* solver, int tries, Summary* summary) {
+    for (size_t a = 0; a < solver->numAnswers; a++) {
+        int taken = solver->results[a] ? solver->results[a] : MAX_TRIES + 1;
+        summary->guesses += taken;
+        summary->failed += taken > tries;
+        if (taken > summary->worst) {
+            summary->worst = taken;
+        }
+    }
+    summary->answers += solver->numAnswers;
+}
+
+void print_summary(char* length, char* guesses, char* first,
+        Summary* summary, double elapsed) {
+    printf("%6s %8zu %8s %-18s %8.4f %6d %6zu %8.3f\n", length,
+            summary->answers, guesses, first,
+            summary->answers ? (double)summary->guesses / summary->answers
+                             : 0,
+            summary->worst, summary->failed, elapsed);
+    fflush(stdout);
+}
+
+void print_game(Solver* solver, size_t answer) {
+    char* word = get_word(solver->answers, solver->wordLen, answer);
+    char hint[MAX_LIST_WORD_LEN + 1];
+    int taken = solver->results[answer];
+    printf("%s:", word);
+    for (int i = 0; i < (taken ? taken : MAX_TRIES); i++) {
+        char* guess = solver->guesses[solver->paths[answer * MAX_TRIES + i]];
+        get_hint(guess, word, solver->wordLen, hint);
+        printf(" %s %s", guess, hint);
+    }
+    if (taken) {
+        printf(" (%d guess%s)\n", taken, taken == 1 ? "" : "es");
+    } else {
+        printf(" (unsolved)\n");
+    }
+}
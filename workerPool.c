@@ -0,0 +1,297 @@
+#include "workerPool.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "session.h"
+
+#define WORKER_STACK_SIZE (128 * 1024)
+#define READ_CHUNK        4096
+
+// Sent to clients turned away because every worker is busy and the queue of
+// clients waiting for one is full.
+#define BUSY_MSG "Server busy, try again later\n"
+
+// Clients accepted but not yet taken by a worker. Only the accepting thread
+// pushes and only workers pop.
+typedef struct {
+    int* fds;
+    int capacity;
+    int head;   // Next client to be served
+    int count;
+    int* depth;  // Where count is published for the metrics
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+} AcceptQueue;
+
+typedef struct {
+    ServerDetails* details;
+    StatShard* shards;  // One for each worker, then the acceptor's
+    AcceptQueue queue;
+} WorkerPool;
+
+// A worker keeps its buffers from one client to the next, so serving a
+// client only touches the heap while they grow to the largest it has seen.
+typedef struct {
+    WorkerPool* pool;
+    StatShard* stats;
+    Buffer in;
+    Buffer out;
+} Worker;
+
+bool start_workers(WorkerPool* pool);
+void* worker_thread(void* rawWorker);
+bool push_client(AcceptQueue* queue, int fd);
+int pop_client(AcceptQueue* queue);
+void reject_client(WorkerPool* pool, int fd);
+void serve_blocking_client(Worker* worker, int fd);
+bool set_read_timeout(int fd, Session* session, uint64_t* timeout);
+ssize_t read_input(int fd, Buffer* in, Session* session);
+bool send_replies(int fd, Buffer* out, Session* session);
+
+/* run_worker_pool()
+ * −−−−−−−−−−−−−−−
+ * Starts details->maxClients worker threads and then accepts clients on
+ * this thread, queueing each for the next free worker. Clients that arrive
+ * while the queue is full, or while the server is out of file descriptors,
+ * are told the server is busy and dropped rather than waiting without
+ * limit. Never returns unless the workers could not be started.
+ */
+void run_worker_pool(ServerDetails* details, ServerStats* stats) {
+    raise_fd_limit();
+    WorkerPool* pool = x_calloc(1, sizeof(WorkerPool));
+    pool->details = details;
+    pool->shards = stats->shards;
+    pool->queue.capacity = details->queueSize;
+    pool->queue.fds = x_malloc(sizeof(int) * details->queueSize);
+    pool->queue.depth = &stats->queued;
+    pthread_mutex_init(&pool->queue.lock, NULL);
+    pthread_cond_init(&pool->queue.ready, NULL);
+    if (!start_workers(pool)) {
+        return;
+    }
+
+    // Given up to accept and drop a client when out of fds.
+    int spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    while (true) {
+        int fd = accept(details->fd, NULL, NULL);
+        if (fd < 0) {
+            if ((errno == EMFILE || errno == ENFILE) && spareFd >= 0) {
+                close(spareFd);
+                if ((fd = accept(details->fd, NULL, NULL)) >= 0) {
+                    reject_client(pool, fd);
+                }
+                spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+            }
+            continue;
+        }
+        if (!push_client(&pool->queue, fd)) {
+            reject_client(pool, fd);
+        }
+    }
+}
+
+/* start_workers()
+ * −−−−−−−−−−−−−−−
+ * Spawns the pool's workers up front, with small stacks as a worker only
+ * ever runs one Session at a time, each keeping its own statistics shard.
+ *
+ * Returns: false if not a single worker could be created, otherwise true.
+ */
+bool start_workers(WorkerPool* pool) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attr, WORKER_STACK_SIZE < PTHREAD_STACK_MIN
+                    ? PTHREAD_STACK_MIN : WORKER_STACK_SIZE);
+
+    int started = 0;
+    pthread_t tid;
+    Worker* workers = x_calloc(pool->details->maxClients, sizeof(Worker));
+    for (int i = 0; i < pool->details->maxClients; i++) {
+        workers[i].pool = pool;
+        workers[i].stats = &pool->shards[i];
+        if (pthread_create(&tid, &attr, worker_thread, &workers[i])) {
+            perror("pthread_create");
+            break;
+        }
+        started++;
+    }
+    pthread_attr_destroy(&attr);
+    if (started && started < pool->details->maxClients) {
+        fprintf(stderr, "wordle-server: only %d of %d workers started\n",
+                started, pool->details->maxClients);
+    }
+    return started > 0;
+}
+
+void* worker_thread(void* rawWorker) {
+    Worker* worker = rawWorker;
+    WorkerPool* pool = worker->pool;
+    while (true) {
+        serve_blocking_client(worker, pop_client(&pool->queue));
+    }
+    return NULL;
+}
+
+/* push_client()
+ * −−−−−−−−−−−−−−−
+ * Returns: false if the queue is full, otherwise true.
+ */
+bool push_client(AcceptQueue* queue, int fd) {
+    pthread_mutex_lock(&queue->lock);
+    bool ok = queue->count < queue->capacity;
+    if (ok) {
+        queue->fds[(queue->head + queue->count) % queue->capacity] = fd;
+        queue->count++;
+        __atomic_store_n(queue->depth, queue->count, __ATOMIC_RELAXED);
+        pthread_cond_signal(&queue->ready);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ok;
+}
+
+// Waits for and removes the longest waiting client.
+int pop_client(AcceptQueue* queue) {
+    pthread_mutex_lock(&queue->lock);
+    while (!queue->count) {
+        pthread_cond_wait(&queue->ready, &queue->lock);
+    }
+    int fd = queue->fds[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+    __atomic_store_n(queue->depth, queue->count, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&queue->lock);
+    return fd;
+}
+
+void reject_client(WorkerPool* pool, int fd) {
+    // Never wait on a client that is being turned away.
+    send(fd, BUSY_MSG, strlen(BUSY_MSG), MSG_DONTWAIT | MSG_NOSIGNAL);
+    close(fd);
+    increment_stat(&pool->shards[pool->details->maxClients].rejected);
+}
+
+/* serve_blocking_client()
+ * −−−−−−−−−−−−−−−
+ * Drives a Session with blocking reads and writes on the client's socket
+ * until the client leaves or times out, then closes it. Everything that
+ * arrived in one read is processed before the replies are sent together,
+ * so a guess costs a single read and a single send. A client that stops
+ * reading its replies is dropped after the idle timeout too.
+ */
+void serve_blocking_client(Worker* worker, int fd) {
+    ServerDetails* details = worker->pool->details;
+    StatShard* stats = worker->stats;
+    client_connected(stats);
+    Session session;
+    Buffer* in = &worker->in;
+    Buffer* out = &worker->out;
+    buffer_consume(in, buffer_used(in));
+    buffer_consume(out, buffer_used(out));
+    start_session(&session, details, stats, out);
+    uint64_t timeout = 0;  // The socket's receive timeout, 0 for none
+    if (details->idleTimeout) {
+        struct timeval timeout = {.tv_sec = details->idleTimeout};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+    while (send_replies(fd, out, &session)
+            && session.state != SESSION_CLOSED) {
+        feed_session(&session, in);
+        if (session.state == SESSION_CLOSED || buffer_used(out)) {
+            continue;
+        }
+        if (buffer_used(in) > MAX_LINE_LEN) {
+            break;
+        }
+        ssize_t size = 0;
+        if (!set_read_timeout(fd, &session, &timeout)
+                || ((size = read_input(fd, in, &session)) < 0
+                        && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+            time_out_session(&session);
+        } else if (size <= 0) {
+            end_session(&session, in);
+        }
+    }
+    close_session(&session);
+    close(fd);
+
+    client_disconnected(stats);
+}
+
+/* set_read_timeout()
+ * −−−−−−−−−−−−−−−
+ * Makes the socket's reads time out at the session's deadline. timeout is
+ * the receive timeout in milliseconds the socket already has, and the
+ * socket is only changed when that differs, so with just an idle timeout
+ * it is set once and each read stays a single system call.
+ *
+ * Returns: false if the deadline has already passed, otherwise true.
+ */
+bool set_read_timeout(int fd, Session* session, uint64_t* timeout) {
+    uint64_t now = monotonic_ms();
+    uint64_t deadline = session_deadline(session, now);
+    if (deadline && deadline <= now) {
+        return false;
+    }
+    uint64_t wanted = deadline ? deadline - now : 0;
+    if (wanted != *timeout) {
+        struct timeval value = {.tv_sec = wanted / 1000,
+                .tv_usec = wanted % 1000 * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value));
+        *timeout = wanted;
+    }
+    return true;
+}
+
+/* read_input()
+ * −−−−−−−−−−−−−−−
+ * Waits for the client to send more input, until the socket's receive
+ * timeout, and appends it to in.
+ *
+ * Returns: the number of bytes read, 0 at end of file, or -1 with errno
+ * set to EAGAIN if the timeout passed or otherwise if the connection
+ * failed.
+ */
+ssize_t read_input(int fd, Buffer* in, Session* session) {
+    ssize_t size;
+    TRACE_BEGIN(TRACE_READ, session->id);
+    do {
+        size = read(fd, buffer_reserve(in, READ_CHUNK), READ_CHUNK);
+    } while (size < 0 && errno == EINTR);
+    TRACE_END(TRACE_READ, session->id);
+    if (size > 0) {
+        in->len += size;
+        add_bytes(&session->stats->bytesIn, size);
+    }
+    return size;
+}
+
+/* send_replies()
+ * −−−−−−−−−−−−−−−
+ * Writes all of the session's pending replies to the client.
+ *
+ * Returns: false if the client can no longer be written to, otherwise
+ * true.
+ */
+bool send_replies(int fd, Buffer* out, Session* session) {
+    while (buffer_used(out)) {
+        TRACE_BEGIN(TRACE_SEND, session->id);
+        ssize_t size = send(fd, out->data + out->start, buffer_used(out),
+                MSG_NOSIGNAL);
+        TRACE_END(TRACE_SEND, session->id);
+        if (size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            buffer_consume(out, buffer_used(out));
+            return false;
+        }
+        buffer_consume(out, size);
+        add_bytes(&session->stats->bytesOut, size);
+    }
+    return true;
+}
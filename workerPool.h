@@ -0,0 +1,8 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "wordleServer.h"
+
+void run_worker_pool(ServerDetails* details, ServerStats* stats);
+
+#endif  // WORKER_POOL_H